@@ -1,3 +1,5 @@
+#include "iguana/json_arena.hpp"
+#include "iguana/json_index.hpp"
 #include "iguana/json_reader.hpp"
 #include "iguana/json_writer.hpp"
 #include "iguana/value.hpp"
@@ -212,6 +214,14 @@ void test_from_json(std::string filename, auto &obj, const auto &json_str,
     }
   }
 
+  std::string two_stage_str = "iguana two-stage from_json " + filename;
+  {
+    ScopedTimer timer(two_stage_str.data());
+    for (int i = 0; i < size; ++i) {
+      iguana::from_json_indexed(obj, std::string_view(json_str));
+    }
+  }
+
 #ifdef HAS_RAPIDJSON
   rapidjson::Document doc;
   doc.Parse(json_str.data(), json_str.size());
@@ -236,6 +246,15 @@ void test_dom_parse(std::string filename, const auto &json_str,
       iguana::parse(val, json_str);
     }
   }
+
+  std::string arena_str = "iguana arena parse " + filename;
+  iguana::json_arena arena;
+  {
+    ScopedTimer timer(arena_str.data());
+    for (int i = 0; i < size; ++i) {
+      iguana::parse<true>(arena, json_str);
+    }
+  }
 }
 
 void test_to_json() {
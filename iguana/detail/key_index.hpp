@@ -0,0 +1,164 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#include "../define.h"
+#include "../reflection.hpp"
+
+namespace iguana::detail {
+
+// the member names of T as the struct map spells them
+template <typename T> constexpr auto member_names() {
+  using M = decltype(iguana_reflect_members(std::declval<T>()));
+  std::array<std::string_view, M::value()> names{};
+  for (size_t i = 0; i < names.size(); ++i) {
+    const auto name = filter_str(M::arr()[i]);
+    names[i] = std::string_view(name.data(), name.size());
+  }
+  return names;
+}
+
+// the same value at compile time and at run time
+IGUANA_INLINE constexpr uint32_t load_le32(const char *p) noexcept {
+  if (!std::is_constant_evaluated() &&
+      std::endian::native == std::endian::little) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  uint32_t v = 0;
+  for (int i = 0; i < 4; ++i) {
+    v |= static_cast<uint32_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+  }
+  return v;
+}
+
+// A key packed into one word from its length and its first and last four
+// bytes, every byte of keys up to 8 bytes long.
+IGUANA_INLINE constexpr uint64_t key_word(std::string_view key) noexcept {
+  const size_t n = key.size();
+  uint64_t w;
+  if (n >= 4) {
+    w = load_le32(key.data()) |
+        static_cast<uint64_t>(load_le32(key.data() + n - 4)) << 32;
+  } else if (n > 0) {
+    w = static_cast<uint8_t>(key[0]) |
+        static_cast<uint64_t>(static_cast<uint8_t>(key[n / 2])) << 8 |
+        static_cast<uint64_t>(static_cast<uint8_t>(key[n - 1])) << 16;
+  } else {
+    w = 0;
+  }
+  return w ^ (n * 0x9E3779B97F4A7C15ull);
+}
+
+// every byte of the key, for names that key_word cannot tell apart
+IGUANA_INLINE constexpr uint64_t key_fnv1a(std::string_view key) noexcept {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (char c : key) {
+    h = (h ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+  }
+  return h;
+}
+
+// Multiply shift hash into a table of 1 << bits slots.
+struct key_hash {
+  uint64_t seed = 0;
+  uint32_t bits = 1;
+  bool full = false; // hash every byte instead of the key word
+
+  IGUANA_INLINE constexpr size_t operator()(std::string_view key) const
+      noexcept {
+    uint64_t x = full ? key_fnv1a(key) : key_word(key);
+    x ^= x >> 31;
+    return static_cast<size_t>((x * seed) >> (64 - bits));
+  }
+};
+
+// Searches for a seed and the smallest table, up to 16 slots per name,
+// that maps every name to its own slot.
+template <size_t N>
+constexpr key_hash
+find_key_hash(const std::array<std::string_view, N> &names) {
+  bool full = false;
+  for (size_t i = 0; i < N && !full; ++i) {
+    for (size_t j = 0; j < i; ++j) {
+      if (key_word(names[i]) == key_word(names[j])) {
+        full = true;
+        break;
+      }
+    }
+  }
+  uint32_t min_bits = 1;
+  while ((size_t{1} << min_bits) < N) {
+    ++min_bits;
+  }
+  for (uint32_t bits = min_bits; bits <= min_bits + 4; ++bits) {
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    for (int attempt = 0; attempt < 256; ++attempt) {
+      // splitmix64
+      state += 0x9E3779B97F4A7C15ull;
+      uint64_t seed = state;
+      seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+      seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBull;
+      seed = (seed ^ (seed >> 31)) | 1;
+      const key_hash hash{seed, bits, full};
+      std::array<bool, (N < 2 ? 2 : N) * 32> used{};
+      bool perfect = true;
+      for (size_t i = 0; i < N && perfect; ++i) {
+        const size_t slot = hash(names[i]);
+        perfect = !used[slot];
+        used[slot] = true;
+      }
+      if (perfect) {
+        return hash;
+      }
+    }
+  }
+  return {}; // not reached for distinct names in practice
+}
+
+template <typename T>
+inline constexpr auto member_names_v = member_names<T>();
+
+// Finds the index of a name among Names: one hash of the name picks the only
+// candidate, a single comparison confirms it.
+template <const auto &Names> struct name_index {
+  static constexpr auto &names = Names;
+  static constexpr size_t size = Names.size();
+  static constexpr key_hash hash = find_key_hash(Names);
+
+  static constexpr auto make_table() {
+    std::array<uint16_t, size_t{1} << hash.bits> table{};
+    table.fill(static_cast<uint16_t>(size));
+    for (size_t i = 0; i < size; ++i) {
+      table[hash(names[i])] = static_cast<uint16_t>(i);
+    }
+    return table;
+  }
+  static constexpr auto table = make_table();
+
+  static_assert(
+      [] {
+        for (size_t i = 0; i < size; ++i) {
+          if (table[hash(names[i])] != i)
+            return false;
+        }
+        return true;
+      }(),
+      "no perfect hash was found for the member names");
+
+  // the index of the name, size if there is none
+  IGUANA_INLINE static constexpr size_t find(std::string_view key) noexcept {
+    const size_t i = table[hash(key)];
+    return i < size && names[i] == key ? i : size;
+  }
+};
+
+// Finds the member of T a json key names.
+template <typename T> struct key_index : name_index<member_names_v<T>> {};
+
+} // namespace iguana::detail
@@ -0,0 +1,287 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#include "../define.h"
+
+// Pick the widest vector unit the translation unit is compiled for. The 16 byte
+// x86 path only needs SSE2, so it is always available on x86-64.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define IGUANA_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IGUANA_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define IGUANA_SIMD_NEON
+#endif
+
+namespace iguana::detail {
+
+#if defined(IGUANA_SIMD_AVX2)
+constexpr inline const char *simd_arch = "avx2";
+#elif defined(IGUANA_SIMD_SSE2)
+constexpr inline const char *simd_arch = "sse2";
+#elif defined(IGUANA_SIMD_NEON)
+constexpr inline const char *simd_arch = "neon";
+#else
+constexpr inline const char *simd_arch = "swar";
+#endif
+
+// 64 bytes of input held in vector registers, every comparison yields one bit
+// per input byte (bit i <=> byte i).
+class simd_block64 {
+public:
+  IGUANA_INLINE explicit simd_block64(const char *p) noexcept {
+#if defined(IGUANA_SIMD_AVX2)
+    lo_ = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    hi_ = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32));
+#elif defined(IGUANA_SIMD_SSE2)
+    for (int i = 0; i < 4; ++i)
+      v_[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16 * i));
+#elif defined(IGUANA_SIMD_NEON)
+    for (int i = 0; i < 4; ++i)
+      v_[i] = vld1q_u8(reinterpret_cast<const uint8_t *>(p + 16 * i));
+#else
+    std::memcpy(w_, p, 64);
+#endif
+  }
+
+  // bytes equal to c
+  IGUANA_INLINE uint64_t eq(char c) const noexcept {
+#if defined(IGUANA_SIMD_AVX2)
+    const __m256i m = _mm256_set1_epi8(c);
+    const uint64_t lo =
+        static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo_, m)));
+    const uint64_t hi =
+        static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi_, m)));
+    return lo | (hi << 32);
+#elif defined(IGUANA_SIMD_SSE2)
+    const __m128i m = _mm_set1_epi8(c);
+    uint64_t r = 0;
+    for (int i = 0; i < 4; ++i)
+      r |= static_cast<uint64_t>(static_cast<uint16_t>(
+               _mm_movemask_epi8(_mm_cmpeq_epi8(v_[i], m))))
+           << (16 * i);
+    return r;
+#elif defined(IGUANA_SIMD_NEON)
+    const uint8x16_t m = vdupq_n_u8(static_cast<uint8_t>(c));
+    return to_bits(vceqq_u8(v_[0], m), vceqq_u8(v_[1], m), vceqq_u8(v_[2], m),
+                   vceqq_u8(v_[3], m));
+#else
+    uint64_t r = 0;
+    const uint64_t m = 0x0101010101010101ull * static_cast<uint8_t>(c);
+    for (int i = 0; i < 8; ++i)
+      r |= swar_zero_bytes(w_[i] ^ m) << (8 * i);
+    return r;
+#endif
+  }
+
+  // bytes strictly below c (unsigned compare), e.g. control characters
+  IGUANA_INLINE uint64_t lt(uint8_t c) const noexcept {
+#if defined(IGUANA_SIMD_AVX2)
+    // a < c  <=>  max(a, c - 1) == c - 1
+    const __m256i m = _mm256_set1_epi8(static_cast<char>(c - 1));
+    const uint64_t lo = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(lo_, m), m)));
+    const uint64_t hi = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(hi_, m), m)));
+    return lo | (hi << 32);
+#elif defined(IGUANA_SIMD_SSE2)
+    const __m128i m = _mm_set1_epi8(static_cast<char>(c - 1));
+    uint64_t r = 0;
+    for (int i = 0; i < 4; ++i)
+      r |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(
+               _mm_cmpeq_epi8(_mm_max_epu8(v_[i], m), m))))
+           << (16 * i);
+    return r;
+#elif defined(IGUANA_SIMD_NEON)
+    const uint8x16_t m = vdupq_n_u8(c);
+    return to_bits(vcltq_u8(v_[0], m), vcltq_u8(v_[1], m), vcltq_u8(v_[2], m),
+                   vcltq_u8(v_[3], m));
+#else
+    uint64_t r = 0;
+    const auto *b = reinterpret_cast<const uint8_t *>(w_);
+    for (int i = 0; i < 64; ++i)
+      r |= static_cast<uint64_t>(b[i] < c) << i;
+    return r;
+#endif
+  }
+
+private:
+#if defined(IGUANA_SIMD_AVX2)
+  __m256i lo_, hi_;
+#elif defined(IGUANA_SIMD_SSE2)
+  __m128i v_[4];
+#elif defined(IGUANA_SIMD_NEON)
+  uint8x16_t v_[4];
+
+  IGUANA_INLINE static uint64_t to_bits(uint8x16_t a, uint8x16_t b,
+                                        uint8x16_t c, uint8x16_t d) noexcept {
+    const uint8x16_t weight = {1, 2, 4, 8, 16, 32, 64, 128,
+                               1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t s0 = vpaddq_u8(vandq_u8(a, weight), vandq_u8(b, weight));
+    uint8x16_t s1 = vpaddq_u8(vandq_u8(c, weight), vandq_u8(d, weight));
+    s0 = vpaddq_u8(s0, s1);
+    s0 = vpaddq_u8(s0, s0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(s0), 0);
+  }
+#else
+  uint64_t w_[8];
+
+  // exact per byte zero test, one bit per byte
+  IGUANA_INLINE static uint64_t swar_zero_bytes(uint64_t x) noexcept {
+    constexpr uint64_t low7 = 0x7F7F7F7F7F7F7F7Full;
+    uint64_t t = ~(((x & low7) + low7) | x | low7);
+    // gather the high bit of every byte into the low 8 bits
+    return ((t >> 7) * 0x0102040810204080ull) >> 56;
+  }
+#endif
+};
+
+// bit i is set when an odd number of bits at positions <= i are set
+IGUANA_INLINE constexpr uint64_t prefix_xor(uint64_t x) noexcept {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+// Returns the bytes that are escaped by a backslash. prev_escaped carries
+// whether the first byte of the next block is escaped.
+// https://github.com/simdjson/simdjson (find_escaped_branchless)
+IGUANA_INLINE uint64_t escaped_bits(uint64_t backslash,
+                                    uint64_t &prev_escaped) noexcept {
+  backslash &= ~prev_escaped;
+  const uint64_t follows_escape = backslash << 1 | prev_escaped;
+  constexpr uint64_t even_bits = 0x5555555555555555ull;
+  const uint64_t odd_sequence_starts =
+      backslash & ~even_bits & ~follows_escape;
+  const uint64_t sum = odd_sequence_starts + backslash;
+  prev_escaped = sum < backslash;
+  const uint64_t invert_mask = sum << 1;
+  return (even_bits ^ invert_mask) & follows_escape;
+}
+
+// Tracks string state across consecutive 64 byte blocks.
+struct string_scanner {
+  uint64_t prev_escaped = 0;
+  uint64_t prev_in_string = 0; // all ones or zero
+
+  struct result {
+    uint64_t quote;     // unescaped quotes
+    uint64_t in_string; // opening quote and string content, not closing quote
+  };
+
+  IGUANA_INLINE result next(const simd_block64 &block) noexcept {
+    const uint64_t backslash = block.eq('\\');
+    uint64_t escaped = 0;
+    if (backslash || prev_escaped) [[unlikely]] {
+      escaped = escaped_bits(backslash, prev_escaped);
+    }
+    const uint64_t quote = block.eq('"') & ~escaped;
+    const uint64_t in_string = prefix_xor(quote) ^ prev_in_string;
+    prev_in_string =
+        static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+    return {quote, in_string};
+  }
+};
+
+// Width of the blocks json_escape_index scans, 32 bytes with AVX2, 16 with
+// SSE2/NEON and 8 (one word) otherwise.
+#if defined(IGUANA_SIMD_AVX2)
+constexpr inline size_t escape_block_size = 32;
+#elif defined(IGUANA_SIMD_SSE2) || defined(IGUANA_SIMD_NEON)
+constexpr inline size_t escape_block_size = 16;
+#else
+constexpr inline size_t escape_block_size = 8;
+#endif
+
+// Index of the first byte in p[0, escape_block_size) that must be escaped in
+// a json string ('"', '\\' or a control character), escape_block_size if
+// there is none.
+IGUANA_INLINE size_t json_escape_index(const char *p) noexcept {
+#if defined(IGUANA_SIMD_AVX2)
+  const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  const __m256i ctrl = _mm256_set1_epi8(0x1F);
+  const __m256i m = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+      _mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl), ctrl));
+  const auto bits = static_cast<uint32_t>(_mm256_movemask_epi8(m));
+  return bits ? std::countr_zero(bits) : escape_block_size;
+#elif defined(IGUANA_SIMD_SSE2)
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  const __m128i ctrl = _mm_set1_epi8(0x1F);
+  const __m128i m =
+      _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                   _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl));
+  const auto bits = static_cast<uint32_t>(_mm_movemask_epi8(m));
+  return bits ? std::countr_zero(bits) : escape_block_size;
+#elif defined(IGUANA_SIMD_NEON)
+  const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+  const uint8x16_t m =
+      vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')),
+                        vceqq_u8(v, vdupq_n_u8('\\'))),
+               vcltq_u8(v, vdupq_n_u8(0x20)));
+  // 4 bits per byte
+  const uint64_t bits = vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+  return bits ? std::countr_zero(bits) >> 2 : escape_block_size;
+#else
+  uint64_t w;
+  std::memcpy(&w, p, sizeof(w));
+  constexpr uint64_t ones = 0x0101010101010101ull;
+  constexpr uint64_t high = 0x8080808080808080ull;
+  auto has_zero = [](uint64_t x) { return (x - ones) & ~x & high; };
+  // a borrow may flag bytes above a match, never below it
+  const uint64_t bits = has_zero(w ^ (ones * '"')) |
+                        has_zero(w ^ (ones * '\\')) |
+                        ((w - ones * 0x20) & ~w & high);
+  return bits ? std::countr_zero(bits) >> 3 : escape_block_size;
+#endif
+}
+
+// Index of the first '"' or '\\' in p[0, escape_block_size), escape_block_size
+// if there is none. Unlike json_escape_index control characters pass.
+IGUANA_INLINE size_t quote_or_backslash_index(const char *p) noexcept {
+#if defined(IGUANA_SIMD_AVX2)
+  const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  const __m256i m =
+      _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+  const auto bits = static_cast<uint32_t>(_mm256_movemask_epi8(m));
+  return bits ? std::countr_zero(bits) : escape_block_size;
+#elif defined(IGUANA_SIMD_SSE2)
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  const __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                 _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+  const auto bits = static_cast<uint32_t>(_mm_movemask_epi8(m));
+  return bits ? std::countr_zero(bits) : escape_block_size;
+#elif defined(IGUANA_SIMD_NEON)
+  const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+  const uint8x16_t m =
+      vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\')));
+  const uint64_t bits = vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+  return bits ? std::countr_zero(bits) >> 2 : escape_block_size;
+#else
+  uint64_t w;
+  std::memcpy(&w, p, sizeof(w));
+  constexpr uint64_t ones = 0x0101010101010101ull;
+  constexpr uint64_t high = 0x8080808080808080ull;
+  auto has_zero = [](uint64_t x) { return (x - ones) & ~x & high; };
+  const uint64_t bits =
+      has_zero(w ^ (ones * '"')) | has_zero(w ^ (ones * '\\'));
+  return bits ? std::countr_zero(bits) >> 3 : escape_block_size;
+#endif
+}
+
+} // namespace iguana::detail
@@ -5,9 +5,10 @@
 
 namespace iguana {
 // https://github.com/Tencent/rapidjson/blob/master/include/rapidjson/reader.h
+// returns false on an invalid hex digit
 template <typename Ch = char, typename It>
-inline unsigned parse_unicode_hex4(It &&it) {
-  unsigned codepoint = 0;
+inline bool parse_unicode_hex4(It &&it, unsigned &codepoint) {
+  codepoint = 0;
   for (int i = 0; i < 4; i++) {
     Ch c = *it;
     codepoint <<= 4;
@@ -19,11 +20,11 @@ inline unsigned parse_unicode_hex4(It &&it) {
     else if (c >= 'a' && c <= 'f')
       codepoint -= 'a' - 10;
     else {
-      throw std::runtime_error("Invalid Unicode Escape Hex");
+      return false;
     }
     ++it;
   }
-  return codepoint;
+  return true;
 }
 
 // https://github.com/Tencent/rapidjson/blob/master/include/rapidjson/encodings.h
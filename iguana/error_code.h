@@ -1,7 +1,11 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
 #include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
 #include <system_error>
 
 namespace iguana {
@@ -12,6 +16,7 @@ public:
     return "iguana::category";
   }
   virtual std::string message(int err_val) const override {
+    std::lock_guard lock(mtx_);
     for (auto &pair : err_map_) {
       if (pair.second == err_val) {
         return pair.first;
@@ -22,6 +27,7 @@ public:
   }
 
   int add_message(const std::string &msg) {
+    std::lock_guard lock(mtx_);
     if (auto it = err_map_.find(msg); it != err_map_.end()) {
       return it->second;
     } else {
@@ -33,6 +39,7 @@ public:
 
   int err_ = 0;
   std::map<std::string, int> err_map_;
+  mutable std::mutex mtx_;
 };
 
 inline iguana::iguana_category &category() {
@@ -40,6 +47,8 @@ inline iguana::iguana_category &category() {
   return instance;
 }
 
+// Registers a free form message, kept for compatibility. The readers report
+// through json_category() which needs no registration.
 inline std::error_code make_error_code(const std::string data = "") {
   assert(!data.empty());
 
@@ -47,52 +56,172 @@ inline std::error_code make_error_code(const std::string data = "") {
   return std::error_code(err, iguana::category());
 }
 
-// dom parse error code
-enum class dom_errc {
+// json parse error code, the expected token is part of the code
+enum class json_errc {
   ok = 0,
-  wrong_type,
+  unexpected_end,
+  expected_quote,
+  expected_colon,
+  expected_comma,
+  expected_brace,
+  expected_close_brace,
+  expected_bracket,
+  expected_close_bracket,
+  expected_true_false,
+  invalid_literal,
+  invalid_number,
+  number_too_long,
+  invalid_escape,
+  invalid_comment,
+  unknown_key,
+  duplicated_key,
+  unexpected_value,
+  too_large,
+  empty_file,
+  invalid_pointer,
+  pointer_not_found,
 };
 
-class iguana_dom_category : public std::error_category {
-public:
-  virtual const char *name() const noexcept override {
-    return "iguana::dom_category";
+constexpr std::string_view json_errc_message(json_errc err) noexcept {
+  switch (err) {
+  case json_errc::ok:
+    return "ok";
+  case json_errc::unexpected_end:
+    return "Unexpected end";
+  case json_errc::expected_quote:
+    return "Expected \"";
+  case json_errc::expected_colon:
+    return "Expected :";
+  case json_errc::expected_comma:
+    return "Expected ,";
+  case json_errc::expected_brace:
+    return "Expected {";
+  case json_errc::expected_close_brace:
+    return "Expected }";
+  case json_errc::expected_bracket:
+    return "Expected [";
+  case json_errc::expected_close_bracket:
+    return "Expected ]";
+  case json_errc::expected_true_false:
+    return "Expected true or false";
+  case json_errc::invalid_literal:
+    return "Invalid literal";
+  case json_errc::invalid_number:
+    return "Failed to parse number";
+  case json_errc::number_too_long:
+    return "Number is too long";
+  case json_errc::invalid_escape:
+    return "Invalid escape";
+  case json_errc::invalid_comment:
+    return "Expected / or * after /";
+  case json_errc::unknown_key:
+    return "Unknown key";
+  case json_errc::duplicated_key:
+    return "duplicated key";
+  case json_errc::unexpected_value:
+    return "parse failed";
+  case json_errc::too_large:
+    return "json is too large to be indexed";
+  case json_errc::empty_file:
+    return "empty file";
+  case json_errc::invalid_pointer:
+    return "Invalid json pointer";
+  case json_errc::pointer_not_found:
+    return "json pointer not found";
   }
-  virtual std::string message(int err_val) const override {
-    switch (static_cast<dom_errc>(err_val)) {
-    case dom_errc::ok:
-      return "ok";
-    case dom_errc::wrong_type: {
-      auto it = detail_msg_map_.find(dom_errc::wrong_type);
-      if (it != detail_msg_map_.end()) {
-        return std::string("wrong type, ")
-            .append("real type is ")
-            .append(it->second);
-      } else {
-        return "wrong type";
+  return "unrecognized error";
+}
+
+// result of the non-throwing json reader
+struct json_error {
+  json_errc code = json_errc::ok;
+  size_t offset = 0; // byte offset of the offending token
+
+  explicit operator bool() const noexcept { return code != json_errc::ok; }
+  std::string_view message() const noexcept { return json_errc_message(code); }
+};
+
+// Error category of the json readers. The value of an error_code packs the
+// json_errc into the low 8 bits and the byte offset into the remaining bits,
+// so no state is shared between threads and nothing is allocated. Compare
+// with ec == json_errc::xxx, the offset is ignored then. Offsets saturate at
+// max_offset (8 MiB - 1), json_error keeps the exact one of larger inputs.
+class json_category_impl : public std::error_category {
+public:
+  static constexpr int code_bits = 8;
+  static constexpr size_t max_offset = (size_t(1) << (31 - code_bits)) - 1;
+
+  const char *name() const noexcept override { return "iguana::json"; }
+
+  std::string message(int value) const override {
+    std::string msg(json_errc_message(code(value)));
+    const auto pos = offset(value);
+    if (pos != 0) {
+      msg.append(" at offset ").append(std::to_string(pos));
+      if (pos == max_offset) {
+        msg.append(" or later");
       }
     }
-    default:
-      return "(unrecognized error)";
-    }
+    return msg;
+  }
+
+  std::error_condition default_error_condition(
+      int value) const noexcept override {
+    return std::error_condition(static_cast<int>(code(value)), *this);
   }
 
-  //    private:
-  std::map<iguana::dom_errc, std::string> detail_msg_map_;
+  static constexpr json_errc code(int value) noexcept {
+    return static_cast<json_errc>(value & ((1 << code_bits) - 1));
+  }
+
+  static constexpr size_t offset(int value) noexcept {
+    return static_cast<size_t>(value) >> code_bits;
+  }
 };
 
-inline iguana::iguana_dom_category &dom_category() {
-  static iguana::iguana_dom_category instance;
+inline const std::error_category &json_category() noexcept {
+  static json_category_impl instance;
   return instance;
 }
 
-inline std::error_code make_error_code(iguana::dom_errc err,
-                                       const std::string &error_msg) {
-  auto &instance = iguana::dom_category();
-  if (!error_msg.empty()) {
-    instance.detail_msg_map_.emplace(err, error_msg);
+// offsets beyond json_category_impl::max_offset are saturated
+inline std::error_code make_error_code(json_errc err,
+                                       size_t offset = 0) noexcept {
+  if (err == json_errc::ok) {
+    return {};
+  }
+  if (offset > json_category_impl::max_offset) {
+    offset = json_category_impl::max_offset;
   }
+  return std::error_code(static_cast<int>(err) |
+                             static_cast<int>(offset
+                                              << json_category_impl::code_bits),
+                         json_category());
+}
+
+inline std::error_code make_error_code(const json_error &err) noexcept {
+  return make_error_code(err.code, err.offset);
+}
+
+inline std::error_condition make_error_condition(json_errc err) noexcept {
+  return std::error_condition(static_cast<int>(err), json_category());
+}
 
-  return std::error_code((int)err, instance);
+// byte offset carried by an error of json_category(), 0 otherwise
+inline size_t error_offset(const std::error_code &ec) noexcept {
+  if (ec.category() != json_category()) {
+    return 0;
+  }
+  return json_category_impl::offset(ec.value());
 }
+
+// dom parse error code, its category is defined with the dom in value.hpp
+enum class dom_errc {
+  ok = 0,
+  wrong_type,
+};
 } // namespace iguana
+
+namespace std {
+template <> struct is_error_condition_enum<iguana::json_errc> : true_type {};
+} // namespace std
@@ -0,0 +1,517 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json_reader.hpp"
+
+namespace iguana {
+
+enum class json_node_type : uint8_t {
+  null,
+  boolean,
+  integer,          // int64_t
+  unsigned_integer, // uint64_t above INT64_MAX
+  number,           // double
+  string,
+  array,
+  object,
+  raw_number, // source text, see parse<Is_view, true>
+};
+
+struct json_member;
+class json_arena;
+
+namespace detail {
+template <bool Is_view, bool Raw_number> struct arena_builder;
+}
+
+// A 16 byte DOM node. Strings, arrays and objects refer to a flat run of
+// memory owned by a json_arena (or by the input when parsed as view), so a
+// node is only valid as long as its arena.
+class json_node {
+public:
+  json_node() noexcept : i_(0), size_(0), type_(json_node_type::null) {}
+
+  json_node_type type() const noexcept { return type_; }
+  bool is_null() const noexcept { return type_ == json_node_type::null; }
+  bool is_bool() const noexcept { return type_ == json_node_type::boolean; }
+  bool is_int() const noexcept { return type_ == json_node_type::integer; }
+  bool is_uint() const noexcept {
+    return type_ == json_node_type::unsigned_integer;
+  }
+  bool is_double() const noexcept { return type_ == json_node_type::number; }
+  bool is_raw_number() const noexcept {
+    return type_ == json_node_type::raw_number;
+  }
+  bool is_number() const noexcept {
+    return is_int() || is_uint() || is_double() || is_raw_number();
+  }
+  bool is_string() const noexcept { return type_ == json_node_type::string; }
+  bool is_array() const noexcept { return type_ == json_node_type::array; }
+  bool is_object() const noexcept { return type_ == json_node_type::object; }
+
+  // number of elements, members or chars, 0 for scalars
+  size_t size() const noexcept { return size_; }
+
+  // bool, integral, floating point, std::string_view or std::string. Integers
+  // convert to any integral type they fit and to floating point, raw numbers
+  // are converted here.
+  template <typename T> T get() const {
+    std::error_code ec;
+    T value = get<T>(ec);
+    if (ec) {
+      throw std::invalid_argument(std::string(type_name()));
+    }
+    return value;
+  }
+
+  template <typename T> T get(std::error_code &ec) const {
+    using U = std::remove_cvref_t<T>;
+    if constexpr (std::is_same_v<U, bool>) {
+      if (is_bool())
+        return b_;
+    } else if constexpr (std::is_arithmetic_v<U>) {
+      if constexpr (std::is_integral_v<U>) {
+        if (is_int() && std::in_range<U>(i_))
+          return static_cast<U>(i_);
+        if (is_uint() && std::in_range<U>(u_))
+          return static_cast<U>(u_);
+      } else {
+        if (is_double())
+          return static_cast<U>(d_);
+        if (is_int())
+          return static_cast<U>(i_);
+        if (is_uint())
+          return static_cast<U>(u_);
+      }
+      if (is_raw_number())
+        return json_number{std::string_view(str_, size_)}.get<U>(ec);
+    } else if constexpr (std::is_same_v<U, std::string_view> ||
+                         std::is_same_v<U, std::string>) {
+      if (is_string())
+        return U(str_, size_);
+    } else {
+      static_assert(!sizeof(U), "type is not supported by json_node");
+    }
+    ec = iguana::make_error_code(dom_errc::wrong_type, type_name());
+    return U{};
+  }
+
+  // empty unless the node is an array
+  std::span<const json_node> elements() const noexcept {
+    if (!is_array())
+      return {};
+    return {elems_, size_};
+  }
+
+  // empty unless the node is an object, duplicated keys are kept in order
+  std::span<const json_member> members() const noexcept;
+
+  const json_node &operator[](size_t idx) const {
+    if (!is_array()) {
+      throw std::invalid_argument(std::string(type_name()));
+    }
+    if (idx >= size_) {
+      throw std::out_of_range("idx is out of range");
+    }
+    return elems_[idx];
+  }
+
+  // the first member named key, nullptr if missing or not an object
+  const json_node *find(std::string_view key) const noexcept;
+
+  const json_node &at(std::string_view key) const {
+    auto node = find(key);
+    if (node == nullptr) {
+      throw std::invalid_argument("the key is unknown");
+    }
+    return *node;
+  }
+
+  std::string_view type_name() const noexcept {
+    switch (type_) {
+    case json_node_type::null:
+      return "null type";
+    case json_node_type::boolean:
+      return "bool type";
+    case json_node_type::integer:
+      return "int64 type";
+    case json_node_type::unsigned_integer:
+      return "uint64 type";
+    case json_node_type::number:
+      return "double type";
+    case json_node_type::string:
+      return "string type";
+    case json_node_type::array:
+      return "array type";
+    case json_node_type::object:
+      return "object type";
+    case json_node_type::raw_number:
+      return "number type";
+    }
+    return "undefined type";
+  }
+
+private:
+  template <bool Is_view, bool Raw_number>
+  friend struct detail::arena_builder;
+
+  union {
+    const char *str_;
+    const json_node *elems_;
+    const json_member *members_;
+    double d_;
+    int64_t i_;
+    uint64_t u_;
+    bool b_;
+  };
+  uint32_t size_;
+  json_node_type type_;
+};
+
+struct json_member {
+  json_node key; // always a string
+  json_node value;
+};
+
+static_assert(sizeof(json_node) == 16);
+static_assert(sizeof(json_member) == 2 * sizeof(json_node));
+
+inline std::span<const json_member> json_node::members() const noexcept {
+  if (!is_object())
+    return {};
+  return {members_, size_};
+}
+
+inline const json_node *json_node::find(std::string_view key) const noexcept {
+  for (auto &member : members()) {
+    if (std::string_view(member.key.str_, member.key.size_) == key) {
+      return &member.value;
+    }
+  }
+  return nullptr;
+}
+
+// Owns every node, key and string of a parsed document in a few large blocks.
+// Parsing into an arena performs no allocation per node; destroying or
+// clearing it frees the whole document at once.
+class json_arena {
+public:
+  json_arena() = default;
+  explicit json_arena(size_t initial_size) : resource_(initial_size) {}
+  json_arena(const json_arena &) = delete;
+  json_arena &operator=(const json_arena &) = delete;
+
+  const json_node &root() const noexcept { return root_; }
+
+  // invalidates all nodes of the previous document
+  void clear() noexcept {
+    resource_.release();
+    root_ = {};
+  }
+
+private:
+  template <bool Is_view, bool Raw_number>
+  friend struct detail::arena_builder;
+
+  std::pmr::monotonic_buffer_resource resource_;
+  // children of the containers being parsed, reused between documents
+  std::vector<json_node> stack_;
+  std::string unescaped_;
+  json_node root_;
+};
+
+namespace detail {
+
+template <bool Is_view, bool Raw_number> struct arena_builder {
+  json_arena &arena;
+
+  template <typename T> T *allocate(size_t n) {
+    return static_cast<T *>(arena.resource_.allocate(n * sizeof(T), alignof(T)));
+  }
+
+  IGUANA_INLINE json_errc set_string(json_node &out, const char *data,
+                                     size_t size, bool in_input) {
+    if (size > std::numeric_limits<uint32_t>::max()) [[unlikely]]
+      return json_errc::too_large;
+    if (!(Is_view && in_input) && size != 0) {
+      auto copy = allocate<char>(size);
+      std::memcpy(copy, data, size);
+      data = copy;
+    }
+    out.str_ = data;
+    out.size_ = static_cast<uint32_t>(size);
+    out.type_ = json_node_type::string;
+    return json_errc::ok;
+  }
+
+  // it points behind the opening quote
+  IGUANA_INLINE json_errc parse_string(json_node &out, const char *&it,
+                                       const char *end) {
+    auto start = it;
+    if (auto ec = skip_till_escape_or_qoute(it, end); ec != json_errc::ok)
+        [[unlikely]]
+      return ec;
+    if (*it == '"') [[likely]] {
+      const auto size = static_cast<size_t>(it - start);
+      ++it;
+      return set_string(out, start, size, true);
+    }
+    it = start;
+    if (auto ec = parse_item(arena.unescaped_, it, end, true);
+        ec != json_errc::ok) [[unlikely]]
+      return ec;
+    return set_string(out, arena.unescaped_.data(), arena.unescaped_.size(),
+                      false);
+  }
+
+  // moves the children pushed since mark into the arena
+  template <typename T>
+  IGUANA_INLINE json_errc pop_children(json_node &out, size_t mark,
+                                       json_node_type type, const T *&dst) {
+    auto &stack = arena.stack_;
+    const size_t n = stack.size() - mark;
+    const size_t count = n * sizeof(json_node) / sizeof(T);
+    if (count > std::numeric_limits<uint32_t>::max()) [[unlikely]]
+      return json_errc::too_large;
+    T *children = nullptr;
+    if (n != 0) {
+      children = allocate<T>(count);
+      std::memcpy(static_cast<void *>(children), stack.data() + mark,
+                  n * sizeof(json_node));
+    }
+    stack.resize(mark);
+    dst = children;
+    out.size_ = static_cast<uint32_t>(count);
+    out.type_ = type;
+    return json_errc::ok;
+  }
+
+  // it points behind '['
+  json_errc parse_array(json_node &out, const char *&it, const char *end) {
+    skip_ws(it, end);
+    if (it == end) [[unlikely]]
+      return json_errc::unexpected_end;
+    const size_t mark = arena.stack_.size();
+    if (*it == ']') {
+      ++it;
+      return pop_children(out, mark, json_node_type::array, out.elems_);
+    }
+    while (true) {
+      json_node element;
+      if (auto ec = parse_value(element, it, end); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
+      arena.stack_.push_back(element);
+
+      if (it == end) [[unlikely]]
+        return json_errc::expected_close_bracket;
+      if (*it == ']') {
+        ++it;
+        return pop_children(out, mark, json_node_type::array, out.elems_);
+      }
+      if (auto ec = match<','>(it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
+    }
+  }
+
+  // it points behind '{'
+  json_errc parse_object(json_node &out, const char *&it, const char *end) {
+    skip_ws(it, end);
+    if (it == end) [[unlikely]]
+      return json_errc::unexpected_end;
+    const size_t mark = arena.stack_.size();
+    if (*it == '}') {
+      ++it;
+      return pop_children(out, mark, json_node_type::object, out.members_);
+    }
+    while (true) {
+      json_node key;
+      skip_ws(it, end);
+      if (auto ec = match<'"'>(it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
+      if (auto ec = parse_string(key, it, end); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
+      skip_ws(it, end);
+      if (auto ec = match<':'>(it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
+      arena.stack_.push_back(key);
+
+      json_node value;
+      if (auto ec = parse_value(value, it, end); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
+      arena.stack_.push_back(value);
+
+      if (it == end) [[unlikely]]
+        return json_errc::expected_close_brace;
+      if (*it == '}') {
+        ++it;
+        return pop_children(out, mark, json_node_type::object, out.members_);
+      }
+      if (auto ec = match<','>(it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
+    }
+  }
+
+  json_errc parse_value(json_node &out, const char *&it, const char *end) {
+    skip_ws(it, end);
+    if (it == end) [[unlikely]]
+      return json_errc::unexpected_end;
+    switch (*it) {
+    case 'n':
+      if (auto ec = match<"null">(it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
+      out.type_ = json_node_type::null;
+      break;
+    case 'f':
+    case 't':
+      if (auto ec = parse_item(out.b_, it, end); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
+      out.type_ = json_node_type::boolean;
+      break;
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+    case '-': {
+      if constexpr (Raw_number) {
+        auto start = it;
+        while (it != end && is_numeric(*it)) {
+          ++it;
+        }
+        if (static_cast<size_t>(it - start) >
+            std::numeric_limits<uint32_t>::max()) [[unlikely]]
+          return json_errc::too_large;
+        out.str_ = start;
+        out.size_ = static_cast<uint32_t>(it - start);
+        out.type_ = json_node_type::raw_number;
+        break;
+      }
+      number_value num;
+      if (auto ec = parse_number(num, it, end); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
+      switch (num.kind) {
+      case number_value::int64:
+        out.i_ = num.i;
+        out.type_ = json_node_type::integer;
+        break;
+      case number_value::uint64:
+        out.u_ = num.u;
+        out.type_ = json_node_type::unsigned_integer;
+        break;
+      case number_value::floating:
+        out.d_ = num.d;
+        out.type_ = json_node_type::number;
+        break;
+      }
+      break;
+    }
+    case '"':
+      ++it;
+      if (auto ec = parse_string(out, it, end); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
+      break;
+    case '[':
+      ++it;
+      if (auto ec = parse_array(out, it, end); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
+      break;
+    case '{':
+      ++it;
+      if (auto ec = parse_object(out, it, end); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
+      break;
+    default:
+      return json_errc::unexpected_value;
+    }
+    skip_ws(it, end);
+    return json_errc::ok;
+  }
+
+  IGUANA_INLINE json_errc parse(const char *&it, const char *end) {
+    arena.clear();
+    arena.stack_.clear();
+    json_node root;
+    auto ec = parse_value(root, it, end);
+    if (ec == json_errc::ok) [[likely]]
+      arena.root_ = root;
+    return ec;
+  }
+};
+
+} // namespace detail
+
+// Parses into the arena, replacing its previous document. With Is_view the
+// strings and keys without escapes point into the input, with Raw_number the
+// numbers are kept as source text. Either way the input must outlive the
+// arena's document. Malformed input is reported through err, the arena's
+// allocations may still throw std::bad_alloc.
+template <bool Is_view = false, bool Raw_number = false, typename It>
+  requires std::contiguous_iterator<std::decay_t<It>>
+inline void parse(json_arena &arena, It &&first, It &&last,
+                  json_error &err) {
+  const char *begin = std::to_address(first);
+  const char *it = begin;
+  const char *end = begin + std::distance(first, last);
+  auto ec = detail::arena_builder<Is_view, Raw_number>{arena}.parse(it, end);
+  err = detail::make_json_error(ec, begin, it);
+}
+
+template <bool Is_view = false, bool Raw_number = false, typename It>
+  requires std::contiguous_iterator<std::decay_t<It>>
+inline void parse(json_arena &arena, It &&first, It &&last) {
+  json_error err;
+  parse<Is_view, Raw_number>(arena, first, last, err);
+  if (err) [[unlikely]]
+    throw std::runtime_error(std::string(err.message()));
+}
+
+template <bool Is_view = false, bool Raw_number = false, typename It>
+  requires std::contiguous_iterator<std::decay_t<It>>
+inline void parse(json_arena &arena, It &&first, It &&last,
+                  std::error_code &ec) {
+  json_error err;
+  parse<Is_view, Raw_number>(arena, first, last, err);
+  ec = iguana::make_error_code(err);
+}
+
+template <bool Is_view = false, bool Raw_number = false, json_view View>
+inline void parse(json_arena &arena, const View &view) {
+  parse<Is_view, Raw_number>(arena, std::begin(view), std::end(view));
+}
+
+template <bool Is_view = false, bool Raw_number = false, json_view View>
+inline void parse(json_arena &arena, const View &view,
+                  json_error &err) {
+  parse<Is_view, Raw_number>(arena, std::begin(view), std::end(view), err);
+}
+
+template <bool Is_view = false, bool Raw_number = false, json_view View>
+inline void parse(json_arena &arena, const View &view,
+                  std::error_code &ec) {
+  parse<Is_view, Raw_number>(arena, std::begin(view), std::end(view), ec);
+}
+
+} // namespace iguana
@@ -0,0 +1,401 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "json_reader.hpp"
+
+namespace iguana {
+
+enum class json_kind : uint8_t {
+  invalid, // missing value or malformed input
+  null,
+  boolean,
+  number,
+  string,
+  array,
+  object,
+};
+
+class json_cursor;
+
+// a member of an object, the key is the raw text between the quotes
+struct json_field;
+
+namespace detail {
+[[noreturn]] IGUANA_INLINE void throw_json_errc(json_errc ec) {
+  throw std::runtime_error(std::string(json_errc_message(ec)));
+}
+
+// it is on the first byte of a value, moves it behind the value
+IGUANA_INLINE void skip_lazy_value(const char *&it, const char *end) {
+  switch (*it) {
+  case '{':
+    skip_until_closed<'{', '}'>(it, end);
+    break;
+  case '[':
+    skip_until_closed<'[', ']'>(it, end);
+    break;
+  case '"':
+    skip_string(it, end);
+    break;
+  default:
+    skip_object_value(it, end);
+  }
+}
+
+// the escapes of raw are decoded one at a time and compared in place
+IGUANA_INLINE bool key_equals(std::string_view raw, std::string_view key) {
+  struct decoded_char {
+    char data[4];
+    size_t size = 0;
+    void push_back(char c) { data[size++] = c; }
+  };
+  // raw is followed by its closing quote
+  const char *end = raw.data() + raw.size() + 1;
+  auto slash = raw.find('\\');
+  while (slash != std::string_view::npos) {
+    if (key.substr(0, slash) != raw.substr(0, slash)) {
+      return false;
+    }
+    key.remove_prefix(slash);
+    const char *it = raw.data() + slash + 1;
+    decoded_char c;
+    if (parse_escape(c, it, end) != json_errc::ok) [[unlikely]]
+      return false;
+    if (!key.starts_with(std::string_view(c.data, c.size))) {
+      return false;
+    }
+    key.remove_prefix(c.size);
+    raw.remove_prefix(static_cast<size_t>(it - raw.data()));
+    slash = raw.find('\\');
+  }
+  return raw == key;
+}
+} // namespace detail
+
+// A position in a json buffer. Nothing is parsed until a value is asked for,
+// subtrees that are not visited are skipped without being parsed. A cursor
+// does not own the buffer.
+class json_cursor {
+public:
+  json_cursor() = default;
+  json_cursor(const char *it, const char *end) noexcept : it_(it), end_(end) {
+    skip_ws(it_, end_);
+  }
+
+  // false for a missing member or element
+  bool valid() const noexcept { return it_ != nullptr && it_ != end_; }
+  explicit operator bool() const noexcept { return valid(); }
+
+  json_kind kind() const noexcept {
+    if (!valid())
+      return json_kind::invalid;
+    switch (*it_) {
+    case '{':
+      return json_kind::object;
+    case '[':
+      return json_kind::array;
+    case '"':
+      return json_kind::string;
+    case 't':
+    case 'f':
+      return json_kind::boolean;
+    case 'n':
+      return json_kind::null;
+    default:
+      return is_numeric(*it_) ? json_kind::number : json_kind::invalid;
+    }
+  }
+
+  bool is_object() const noexcept { return kind() == json_kind::object; }
+  bool is_array() const noexcept { return kind() == json_kind::array; }
+  bool is_string() const noexcept { return kind() == json_kind::string; }
+  bool is_number() const noexcept { return kind() == json_kind::number; }
+  bool is_bool() const noexcept { return kind() == json_kind::boolean; }
+  bool is_null() const noexcept { return kind() == json_kind::null; }
+
+  // Materializes the value with the regular reader, T is anything from_json
+  // accepts, including reflected structs.
+  template <typename T> T get() const {
+    T value{};
+    if (!valid()) [[unlikely]]
+      detail::throw_json_errc(json_errc::unexpected_end);
+    const char *it = it_;
+    const char *end = end_;
+    if (auto ec = detail::parse_item(value, it, end); ec != json_errc::ok)
+        [[unlikely]]
+      throw std::runtime_error(detail::json_error_message(ec, it, end));
+    return value;
+  }
+
+  template <typename T> T get(json_error &err) const {
+    T value{};
+    if (!valid()) [[unlikely]] {
+      err = {json_errc::unexpected_end, 0};
+      return value;
+    }
+    const char *it = it_;
+    const char *end = end_;
+    auto ec = detail::parse_item(value, it, end);
+    err = detail::make_json_error(ec, it_, it);
+    return value;
+  }
+
+  template <typename T> T get(std::error_code &ec) const {
+    json_error err;
+    T value = get<T>(err);
+    ec = iguana::make_error_code(err);
+    return value;
+  }
+
+  // the json text of the value
+  std::string_view raw() const noexcept {
+    if (!valid())
+      return {};
+    const char *it = it_;
+    detail::skip_lazy_value(it, end_);
+    auto last = it;
+    while (last != it_ && static_cast<uint8_t>(last[-1]) < 33) {
+      --last;
+    }
+    return {it_, static_cast<size_t>(last - it_)};
+  }
+
+  class array_iterator;
+  class object_iterator;
+
+  template <typename Iterator> struct range {
+    Iterator first;
+    Iterator begin() const { return first; }
+    Iterator end() const { return {}; }
+  };
+
+  // empty unless the value is an array
+  range<array_iterator> elements() const;
+
+  // empty unless the value is an object
+  range<object_iterator> members() const;
+
+  // the first member named key, an invalid cursor if there is none
+  json_cursor find(std::string_view key) const;
+
+  json_cursor operator[](std::string_view key) const {
+    auto value = find(key);
+    if (!value) {
+      throw std::invalid_argument("the key is unknown");
+    }
+    return value;
+  }
+
+  json_cursor operator[](size_t idx) const;
+
+  std::string_view buffer() const noexcept {
+    if (it_ == nullptr)
+      return {};
+    return {it_, static_cast<size_t>(end_ - it_)};
+  }
+
+private:
+  const char *it_ = nullptr;
+  const char *end_ = nullptr;
+};
+
+struct json_field {
+  std::string_view key; // escape sequences are not decoded
+  json_cursor value;
+};
+
+class json_cursor::array_iterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = json_cursor;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const json_cursor *;
+  using reference = const json_cursor &;
+
+  array_iterator() = default;
+  // it is on '['
+  array_iterator(const char *it, const char *end) : end_(end) {
+    ++it;
+    skip_ws(it, end);
+    if (it == end) [[unlikely]]
+      detail::throw_json_errc(json_errc::unexpected_end);
+    if (*it == ']') {
+      return;
+    }
+    value_ = json_cursor(it, end);
+  }
+
+  reference operator*() const noexcept { return value_; }
+  pointer operator->() const noexcept { return &value_; }
+
+  array_iterator &operator++() {
+    const char *it = value_.it_;
+    detail::skip_lazy_value(it, end_);
+    skip_ws(it, end_);
+    if (it == end_) [[unlikely]]
+      detail::throw_json_errc(json_errc::expected_close_bracket);
+    if (*it == ']') {
+      value_ = {};
+    } else if (*it == ',') [[likely]] {
+      value_ = json_cursor(++it, end_);
+    } else [[unlikely]] {
+      detail::throw_json_errc(json_errc::expected_close_bracket);
+    }
+    return *this;
+  }
+
+  array_iterator operator++(int) {
+    auto tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  bool operator==(const array_iterator &rhs) const noexcept {
+    return value_.it_ == rhs.value_.it_;
+  }
+
+private:
+  const char *end_ = nullptr;
+  json_cursor value_;
+};
+
+class json_cursor::object_iterator {
+public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = json_field;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const json_field *;
+  using reference = const json_field &;
+
+  object_iterator() = default;
+  // it is on '{'
+  object_iterator(const char *it, const char *end) : end_(end) {
+    ++it;
+    skip_ws(it, end);
+    if (it == end) [[unlikely]]
+      detail::throw_json_errc(json_errc::unexpected_end);
+    if (*it == '}') {
+      return;
+    }
+    read_field(it);
+  }
+
+  reference operator*() const noexcept { return field_; }
+  pointer operator->() const noexcept { return &field_; }
+
+  object_iterator &operator++() {
+    const char *it = field_.value.it_;
+    detail::skip_lazy_value(it, end_);
+    skip_ws(it, end_);
+    if (it == end_) [[unlikely]]
+      detail::throw_json_errc(json_errc::expected_close_brace);
+    if (*it == '}') {
+      field_ = {};
+    } else if (*it == ',') [[likely]] {
+      ++it;
+      skip_ws(it, end_);
+      read_field(it);
+    } else [[unlikely]] {
+      detail::throw_json_errc(json_errc::expected_close_brace);
+    }
+    return *this;
+  }
+
+  object_iterator operator++(int) {
+    auto tmp = *this;
+    ++*this;
+    return tmp;
+  }
+
+  bool operator==(const object_iterator &rhs) const noexcept {
+    return field_.value.it_ == rhs.field_.value.it_;
+  }
+
+private:
+  // it is on the opening quote of the key
+  void read_field(const char *it) {
+    if (auto ec = match<'"'>(it, end_); ec != json_errc::ok) [[unlikely]]
+      detail::throw_json_errc(ec);
+    const char *start = it;
+    while (true) {
+      if (auto ec = skip_till_escape_or_qoute(it, end_); ec != json_errc::ok)
+          [[unlikely]]
+        detail::throw_json_errc(ec);
+      if (*it == '"')
+        break;
+      it += 2;
+    }
+    field_.key = std::string_view(start, static_cast<size_t>(it - start));
+    ++it;
+    skip_ws(it, end_);
+    if (auto ec = match<':'>(it, end_); ec != json_errc::ok) [[unlikely]]
+      detail::throw_json_errc(ec);
+    field_.value = json_cursor(it, end_);
+    if (!field_.value) [[unlikely]]
+      detail::throw_json_errc(json_errc::unexpected_end);
+  }
+
+  const char *end_ = nullptr;
+  json_field field_;
+};
+
+inline json_cursor::range<json_cursor::array_iterator>
+json_cursor::elements() const {
+  if (!is_array())
+    return {};
+  return {array_iterator(it_, end_)};
+}
+
+inline json_cursor::range<json_cursor::object_iterator>
+json_cursor::members() const {
+  if (!is_object())
+    return {};
+  return {object_iterator(it_, end_)};
+}
+
+inline json_cursor json_cursor::find(std::string_view key) const {
+  for (auto &field : members()) {
+    if (detail::key_equals(field.key, key)) {
+      return field.value;
+    }
+  }
+  return {};
+}
+
+inline json_cursor json_cursor::operator[](size_t idx) const {
+  for (auto &element : elements()) {
+    if (idx-- == 0) {
+      return element;
+    }
+  }
+  throw std::out_of_range("idx is out of range");
+}
+
+// A lazily parsed json document, the buffer must outlive the document and
+// every cursor taken from it.
+class json_document {
+public:
+  json_document() = default;
+  template <json_view View>
+  explicit json_document(const View &view) noexcept
+      : json_(std::data(view), std::size(view)) {}
+
+  std::string_view buffer() const noexcept { return json_; }
+
+  json_cursor root() const noexcept {
+    return {json_.data(), json_.data() + json_.size()};
+  }
+
+  json_cursor operator[](std::string_view key) const { return root()[key]; }
+  json_cursor operator[](size_t idx) const { return root()[idx]; }
+  json_cursor find(std::string_view key) const { return root().find(key); }
+
+private:
+  std::string_view json_;
+};
+
+} // namespace iguana
@@ -0,0 +1,501 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+#include "detail/simd.hpp"
+#include "json_reader.hpp"
+
+namespace iguana {
+
+// Stage 1 of the two-stage reader: the positions of all structural characters
+// ({}[]:, and both quotes of every string) outside of strings, found with one
+// vectorized pass over the input. Stage 2 (from_json(value, index)) walks these
+// positions instead of rescanning the bytes. Comments are not supported.
+class json_index {
+public:
+  json_index() = default;
+  explicit json_index(std::string_view json) {
+    if (auto ec = build(json); ec != json_errc::ok) [[unlikely]]
+      throw std::runtime_error(std::string(json_errc_message(ec)));
+  }
+
+  [[nodiscard]] json_errc build(std::string_view json) {
+    if (json.size() >= UINT32_MAX) [[unlikely]]
+      return json_errc::too_large;
+
+    // every byte could be structural, +1 keeps room for a full tail block
+    const size_t need = json.size() + 1;
+    if (capacity_ < need) {
+      pos_.reset(new uint32_t[need]);
+      capacity_ = need;
+    }
+
+    buf_ = json;
+    const char *data = json.data();
+    const size_t n = json.size();
+    uint32_t *out = pos_.get();
+    detail::string_scanner scanner{};
+
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+      out = index_block(detail::simd_block64(data + i), scanner, out,
+                        static_cast<uint32_t>(i));
+    }
+    if (i < n) {
+      char tail[64];
+      std::memset(tail, ' ', sizeof(tail));
+      std::memcpy(tail, data + i, n - i);
+      out = index_block(detail::simd_block64(tail), scanner, out,
+                        static_cast<uint32_t>(i));
+    }
+
+    size_ = static_cast<size_t>(out - pos_.get());
+    if (scanner.prev_in_string) [[unlikely]] {
+      return json_errc::expected_quote;
+    }
+    return json_errc::ok;
+  }
+
+  std::string_view buffer() const noexcept { return buf_; }
+  const uint32_t *data() const noexcept { return pos_.get(); }
+  size_t size() const noexcept { return size_; }
+
+private:
+  IGUANA_INLINE static uint32_t *index_block(const detail::simd_block64 &block,
+                                             detail::string_scanner &scanner,
+                                             uint32_t *out, uint32_t base) {
+    const auto [quote, in_string] = scanner.next(block);
+    const uint64_t op = block.eq('{') | block.eq('}') | block.eq('[') |
+                        block.eq(']') | block.eq(':') | block.eq(',');
+    uint64_t structural = (op & ~in_string) | quote;
+    while (structural) {
+      *out++ = base + static_cast<uint32_t>(std::countr_zero(structural));
+      structural &= structural - 1;
+    }
+    return out;
+  }
+
+  std::string_view buf_;
+  std::unique_ptr<uint32_t[]> pos_;
+  size_t capacity_ = 0;
+  size_t size_ = 0;
+};
+
+namespace detail {
+
+struct index_cursor {
+  const char *buf;
+  const char *end;
+  const uint32_t *pos;     // next unconsumed structural
+  const uint32_t *pos_end; //
+  const char *p;           // first byte after the last consumed structural
+
+  IGUANA_INLINE const char *next() const noexcept {
+    return pos < pos_end ? buf + *pos : end;
+  }
+
+  IGUANA_INLINE char peek() const noexcept {
+    return pos < pos_end ? buf[*pos] : '\0';
+  }
+
+  // only whitespace between the last consumed and the next structural
+  IGUANA_INLINE bool adjacent() noexcept {
+    const auto n = next();
+    skip_ws_no_comments(p, n);
+    return p == n;
+  }
+
+  IGUANA_INLINE void consume() noexcept {
+    p = buf + *pos + 1;
+    ++pos;
+  }
+};
+
+template <char c>
+[[nodiscard]] IGUANA_INLINE json_errc index_match(index_cursor &cur) {
+  if (!cur.adjacent() || cur.peek() != c) [[unlikely]]
+    return cur.p == cur.end ? json_errc::unexpected_end : expected_errc<c>();
+  cur.consume();
+  return json_errc::ok;
+}
+
+// Hands a value the index has no dedicated path for to the byte parser and
+// resynchronizes the cursor behind it.
+template <typename U>
+IGUANA_INLINE json_errc index_parse_fallback(U &value, index_cursor &cur) {
+  const char *it = cur.p;
+  const char *end = cur.end;
+  auto ec = parse_item(value, it, end);
+  cur.p = it;
+  while (cur.pos < cur.pos_end && cur.buf + *cur.pos < it) {
+    ++cur.pos;
+  }
+  return ec;
+}
+
+template <typename U> json_errc index_parse(U &value, index_cursor &cur);
+
+// the opening quote must be the next structural, raw receives the content
+IGUANA_INLINE json_errc index_string(index_cursor &cur, std::string_view &raw) {
+  if (auto ec = index_match<'"'>(cur); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  if (cur.peek() != '"') [[unlikely]]
+    return json_errc::expected_quote;
+  raw = std::string_view(cur.p, static_cast<size_t>(cur.next() - cur.p));
+  cur.consume();
+  return json_errc::ok;
+}
+
+IGUANA_INLINE json_errc index_unescape(std::string_view raw, auto &value) {
+  if (std::memchr(raw.data(), '\\', raw.size()) == nullptr) [[likely]] {
+    value.assign(raw.data(), raw.size());
+    return json_errc::ok;
+  }
+  // raw is followed by its closing quote
+  const char *it = raw.data();
+  const char *end = raw.data() + raw.size() + 1;
+  return parse_item(value, it, end, true);
+}
+
+IGUANA_INLINE json_errc index_skip_value(index_cursor &cur) {
+  if (!cur.adjacent()) {
+    // scalar, runs until the next structural
+    cur.p = cur.next();
+    return json_errc::ok;
+  }
+  switch (cur.peek()) {
+  case '"': {
+    std::string_view raw;
+    return index_string(cur, raw);
+  }
+  case '{':
+  case '[': {
+    size_t depth = 0;
+    do {
+      const char c = cur.peek();
+      if (c == '{' || c == '[') {
+        ++depth;
+      } else if (c == '}' || c == ']') {
+        --depth;
+      } else if (c == '\0') [[unlikely]] {
+        return json_errc::unexpected_end;
+      }
+      cur.consume();
+    } while (depth != 0);
+    return json_errc::ok;
+  }
+  default:
+    return json_errc::unexpected_value;
+  }
+}
+
+// consumes the separator after an element, done is set on the closing token
+template <char Close>
+IGUANA_INLINE json_errc index_next_element(index_cursor &cur, bool &done) {
+  const char c = cur.peek();
+  if (!cur.adjacent()) [[unlikely]]
+    return expected_errc<Close>();
+  if (c == Close) {
+    done = true;
+  } else if (c != ',') [[unlikely]] {
+    return c == '\0' ? json_errc::unexpected_end : expected_errc<Close>();
+  }
+  cur.consume();
+  return json_errc::ok;
+}
+
+template <typename U, size_t I>
+json_errc index_parse_member(U &value, index_cursor &cur) {
+  using M = decltype(iguana_reflect_members(std::declval<U>()));
+  return index_parse(value.*std::get<I>(M::apply_impl()), cur);
+}
+
+// one index_parse function per member, indexed like key_index<U>
+template <typename U, size_t... Is>
+constexpr auto index_member_parsers(std::index_sequence<Is...>) {
+  return std::array<json_errc (*)(U &, index_cursor &), sizeof...(Is)>{
+      &index_parse_member<U, Is>...};
+}
+
+template <refletable U>
+IGUANA_INLINE json_errc index_parse(U &value, index_cursor &cur) {
+  if (auto ec = index_match<'{'>(cur); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  if (cur.peek() == '}' && cur.adjacent()) [[unlikely]] {
+    cur.consume();
+    return json_errc::ok;
+  }
+  using members = key_index<std::remove_cvref_t<U>>;
+  // as in parse_object the key is first compared with the name of the
+  // member behind the last one
+  size_t expected = 0;
+  for (bool done = false; !done;) {
+    [[maybe_unused]] const char *key_start = cur.p;
+    std::string_view key;
+    if (auto ec = index_string(cur, key); ec != json_errc::ok) [[unlikely]]
+      return ec;
+    size_t index = members::size;
+    if (expected < members::size && key == members::names[expected])
+        [[likely]] {
+      index = expected;
+    } else if (std::memchr(key.data(), '\\', key.size()) != nullptr)
+        [[unlikely]] {
+      static thread_local std::string static_key{};
+      if (auto ec = index_unescape(key, static_key); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
+      key = static_key;
+    } else if (!key.empty() && key[0] == '@') [[unlikely]] {
+      key = key.substr(1);
+    }
+    if (auto ec = index_match<':'>(cur); ec != json_errc::ok) [[unlikely]]
+      return ec;
+
+    if constexpr (members::size > 0) {
+      static constexpr auto parsers = index_member_parsers<U>(
+          std::make_index_sequence<members::size>{});
+      if (index == members::size) {
+        index = members::find(key);
+      }
+      if (index != members::size) [[likely]] {
+        if (auto ec = parsers[index](value, cur); ec != json_errc::ok)
+            [[unlikely]]
+          return ec;
+        expected = index + 1;
+      } else [[unlikely]] {
+#ifdef THROW_UNKNOWN_KEY
+        cur.p = key_start;
+        skip_ws_no_comments(cur.p, cur.end);
+        return json_errc::unknown_key;
+#else
+        if (auto ec = index_skip_value(cur); ec != json_errc::ok) [[unlikely]]
+          return ec;
+#endif
+      }
+    } else {
+      if (auto ec = index_skip_value(cur); ec != json_errc::ok) [[unlikely]]
+        return ec;
+    }
+
+    if (auto ec = index_next_element<'}'>(cur, done); ec != json_errc::ok)
+        [[unlikely]]
+      return ec;
+  }
+  return json_errc::ok;
+}
+
+template <typename U>
+  requires(num_t<U> || bool_t<U> || enum_type_t<U>)
+IGUANA_INLINE json_errc index_parse(U &value, index_cursor &cur) {
+  const char *it = cur.p;
+  const char *end = cur.next();
+  if (auto ec = parse_item(value, it, end); ec != json_errc::ok) [[unlikely]] {
+    cur.p = it;
+    return ec;
+  }
+  skip_ws_no_comments(it, end);
+  if (it != end) [[unlikely]] {
+    cur.p = it;
+    if constexpr (num_t<U>)
+      return json_errc::invalid_number;
+    else
+      return json_errc::unexpected_value;
+  }
+  cur.p = end;
+  return json_errc::ok;
+}
+
+template <str_t U>
+IGUANA_INLINE json_errc index_parse(U &value, index_cursor &cur) {
+  std::string_view raw;
+  if (auto ec = index_string(cur, raw); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  return index_unescape(raw, value);
+}
+
+template <str_view_t U>
+IGUANA_INLINE json_errc index_parse(U &value, index_cursor &cur) {
+  std::string_view raw;
+  if (auto ec = index_string(cur, raw); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  value = std::decay_t<U>(raw.data(), raw.size());
+  return json_errc::ok;
+}
+
+template <optional U>
+IGUANA_INLINE json_errc index_parse(U &value, index_cursor &cur) {
+  using value_type = typename std::remove_cvref_t<U>::value_type;
+  if (!cur.adjacent()) {
+    if (*cur.p == 'n') {
+      const char *it = cur.p;
+      if (auto ec = match<"null">(it, cur.end); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
+      cur.p = it;
+      value.reset();
+      return json_errc::ok;
+    }
+  } else if (cur.peek() == '"' && !(str_t<value_type> ||
+                                    str_view_t<value_type>)) [[unlikely]] {
+    return index_parse_fallback(value, cur);
+  }
+  value_type t;
+  if (auto ec = index_parse(t, cur); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  value = std::move(t);
+  return json_errc::ok;
+}
+
+template <sequence_container U>
+IGUANA_INLINE json_errc index_parse(U &value, index_cursor &cur) {
+  value.clear();
+  if (auto ec = index_match<'['>(cur); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  if (cur.peek() == ']' && cur.adjacent()) {
+    cur.consume();
+    return json_errc::ok;
+  }
+  for (bool done = false; !done;) {
+    if (auto ec = index_parse(value.emplace_back(), cur); ec != json_errc::ok)
+        [[unlikely]]
+      return ec;
+    if (auto ec = index_next_element<']'>(cur, done); ec != json_errc::ok)
+        [[unlikely]]
+      return ec;
+  }
+  return json_errc::ok;
+}
+
+template <fixed_array U>
+IGUANA_INLINE json_errc index_parse(U &value, index_cursor &cur) {
+  using T = std::remove_reference_t<U>;
+  constexpr auto n = sizeof(T) / sizeof(decltype(std::declval<T>()[0]));
+  if (auto ec = index_match<'['>(cur); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  if (cur.peek() == ']' && cur.adjacent()) {
+    cur.consume();
+    return json_errc::ok;
+  }
+  auto value_it = std::begin(value);
+  for (size_t i = 0; i < n; ++i) {
+    if (auto ec = index_parse(*value_it++, cur); ec != json_errc::ok)
+        [[unlikely]]
+      return ec;
+    bool done = false;
+    if (auto ec = index_next_element<']'>(cur, done); ec != json_errc::ok)
+        [[unlikely]]
+      return ec;
+    if (done)
+      return json_errc::ok;
+  }
+  return json_errc::expected_close_bracket;
+}
+
+template <map_container U>
+IGUANA_INLINE json_errc index_parse(U &value, index_cursor &cur) {
+  using key_type = typename std::remove_cvref_t<U>::key_type;
+  if (auto ec = index_match<'{'>(cur); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  if (cur.peek() == '}' && cur.adjacent()) {
+    cur.consume();
+    return json_errc::ok;
+  }
+  for (bool done = false; !done;) {
+    std::string_view raw;
+    if (auto ec = index_string(cur, raw); ec != json_errc::ok) [[unlikely]]
+      return ec;
+    if (auto ec = index_match<':'>(cur); ec != json_errc::ok) [[unlikely]]
+      return ec;
+    json_errc ec;
+    if constexpr (str_view_t<key_type>) {
+      ec = index_parse(value[key_type(raw.data(), raw.size())], cur);
+    } else if constexpr (str_t<key_type>) {
+      static thread_local std::string key{};
+      if (ec = index_unescape(raw, key); ec != json_errc::ok) [[unlikely]]
+        return ec;
+      ec = index_parse(value[key_type(key)], cur);
+    } else {
+      static thread_local key_type key_value{};
+      if (ec = parse_item(key_value, raw.begin(), raw.end());
+          ec != json_errc::ok) [[unlikely]]
+        return ec;
+      ec = index_parse(value[key_value], cur);
+    }
+    if (ec != json_errc::ok) [[unlikely]]
+      return ec;
+    if (ec = index_next_element<'}'>(cur, done); ec != json_errc::ok)
+        [[unlikely]]
+      return ec;
+  }
+  return json_errc::ok;
+}
+
+// tuples, chars and everything else go through the byte parser
+template <typename U>
+IGUANA_INLINE json_errc index_parse(U &value, index_cursor &cur) {
+  return index_parse_fallback(value, cur);
+}
+
+IGUANA_INLINE index_cursor make_index_cursor(const json_index &index) {
+  const auto buf = index.buffer();
+  return {buf.data(), buf.data() + buf.size(), index.data(),
+          index.data() + index.size(), buf.data()};
+}
+
+} // namespace detail
+
+template <typename T>
+IGUANA_INLINE void from_json(T &value, const json_index &index) {
+  auto cur = detail::make_index_cursor(index);
+  if (auto ec = detail::index_parse(value, cur); ec != json_errc::ok)
+      [[unlikely]]
+    throw std::runtime_error(detail::json_error_message(ec, cur.p, cur.end));
+}
+
+template <typename T>
+IGUANA_INLINE void from_json(T &value, const json_index &index,
+                             json_error &err) {
+  auto cur = detail::make_index_cursor(index);
+  auto ec = detail::index_parse(value, cur);
+  err = detail::make_json_error(ec, cur.buf, cur.p);
+}
+
+template <typename T>
+IGUANA_INLINE void from_json(T &value, const json_index &index,
+                             std::error_code &ec) {
+  json_error err;
+  from_json(value, index, err);
+  ec = iguana::make_error_code(err);
+}
+
+// builds the structural index in a per thread buffer and parses with it
+template <typename T>
+IGUANA_INLINE void from_json_indexed(T &value, std::string_view json) {
+  static thread_local json_index index;
+  if (auto ec = index.build(json); ec != json_errc::ok) [[unlikely]]
+    throw std::runtime_error(std::string(json_errc_message(ec)));
+  from_json(value, index);
+}
+
+template <typename T>
+IGUANA_INLINE void from_json_indexed(T &value, std::string_view json,
+                                     json_error &err) {
+  static thread_local json_index index;
+  if (auto ec = index.build(json); ec != json_errc::ok) [[unlikely]] {
+    err = {ec, json.size()};
+    return;
+  }
+  from_json(value, index, err);
+}
+
+template <typename T>
+IGUANA_INLINE void from_json_indexed(T &value, std::string_view json,
+                                     std::error_code &ec) {
+  json_error err;
+  from_json_indexed(value, json, err);
+  ec = iguana::make_error_code(err);
+}
+
+} // namespace iguana
@@ -0,0 +1,205 @@
+#pragma once
+#include <cstring>
+#include <istream>
+#include <string>
+#include <string_view>
+
+#include "detail/simd.hpp"
+#include "json_reader.hpp"
+#include "json_writer.hpp"
+#include "sink.hpp"
+
+namespace iguana {
+
+namespace detail {
+// Calls f(first, last) for every line in [it, end) that ends with '\n', the
+// newlines are found 64 bytes at a time. Returns where the unterminated rest
+// begins, f returning false stops early.
+template <typename F>
+IGUANA_INLINE const char *split_lines(const char *it, const char *end, F &&f) {
+  const char *line = it;
+  while (end - it >= 64) {
+    uint64_t newlines = simd_block64(it).eq('\n');
+    while (newlines) {
+      const char *last = it + std::countr_zero(newlines);
+      if (!f(line, last))
+        return last;
+      line = last + 1;
+      newlines &= newlines - 1;
+    }
+    it += 64;
+  }
+  while (it != end) {
+    auto last = static_cast<const char *>(
+        std::memchr(it, '\n', static_cast<size_t>(end - it)));
+    if (last == nullptr)
+      break;
+    if (!f(line, last))
+      return last;
+    line = it = last + 1;
+  }
+  return line;
+}
+
+// Parses every record into the same value, which is reset by copy assignment
+// from a default constructed T, so its strings and vectors keep their memory.
+template <typename T, typename F> class json_lines_reader {
+public:
+  explicit json_lines_reader(F &f) : f_(f) {}
+
+  // Parses the lines of [it, end) that end with '\n' and returns the
+  // unterminated rest, nullptr after an error or once f asked to stop. base
+  // is the offset of it in the whole input.
+  const char *parse_lines(const char *it, const char *end, size_t base,
+                          json_error &err) {
+    json_errc ec = json_errc::ok;
+    const char *rest =
+        split_lines(it, end, [&](const char *first, const char *last) {
+          ec = parse_line(first, last, base + static_cast<size_t>(first - it),
+                          err);
+          return ec == json_errc::ok && !stopped_;
+        });
+    return ec == json_errc::ok && !stopped_ ? rest : nullptr;
+  }
+
+  // parses all of [it, end), the last line may lack the newline
+  void parse(const char *it, const char *end, size_t base, json_error &err) {
+    const char *rest = parse_lines(it, end, base, err);
+    if (rest != nullptr && rest != end) {
+      (void)parse_line(rest, end, base + static_cast<size_t>(rest - it), err);
+    }
+  }
+
+  size_t count() const noexcept { return count_; }
+
+private:
+  json_errc parse_line(const char *it, const char *end, size_t offset,
+                       json_error &err) {
+    const char *begin = it;
+    skip_ws(it, end);
+    if (it == end) {
+      return json_errc::ok; // blank line
+    }
+    value_ = defaults_;
+    if (auto ec = parse_item(value_, it, end); ec != json_errc::ok)
+        [[unlikely]] {
+      err = {ec, offset + static_cast<size_t>(it - begin)};
+      return ec;
+    }
+    // a line holds exactly one record
+    skip_ws(it, end);
+    if (it != end) [[unlikely]] {
+      err = {json_errc::unexpected_value,
+             offset + static_cast<size_t>(it - begin)};
+      return json_errc::unexpected_value;
+    }
+    ++count_;
+    if constexpr (std::is_same_v<std::invoke_result_t<F &, T &>, bool>) {
+      stopped_ = !f_(value_);
+    } else {
+      f_(value_);
+    }
+    return json_errc::ok;
+  }
+
+  F &f_;
+  T value_{};
+  const T defaults_{};
+  size_t count_ = 0;
+  bool stopped_ = false;
+};
+
+[[noreturn]] IGUANA_INLINE void throw_json_line_error(const json_error &err) {
+  throw std::runtime_error(std::string(err.message()));
+}
+} // namespace detail
+
+// Parses newline delimited json (json lines), f(T&) is called for every
+// record and may return false to stop. The same T is reused for every
+// record, blank lines are skipped. Returns the number of records, err
+// receives the first error and its offset in the buffer.
+template <typename T, json_view View, typename F>
+IGUANA_INLINE size_t for_each_json_line(const View &buffer, F &&f,
+                                        json_error &err) {
+  err = {};
+  const char *data = std::data(buffer);
+  detail::json_lines_reader<T, F> reader(f);
+  reader.parse(data, data + std::size(buffer), 0, err);
+  return reader.count();
+}
+
+template <typename T, json_view View, typename F>
+IGUANA_INLINE size_t for_each_json_line(const View &buffer, F &&f,
+                                        std::error_code &ec) {
+  json_error err;
+  const auto n = for_each_json_line<T>(buffer, std::forward<F>(f), err);
+  ec = iguana::make_error_code(err);
+  return n;
+}
+
+template <typename T, json_view View, typename F>
+IGUANA_INLINE size_t for_each_json_line(const View &buffer, F &&f) {
+  json_error err;
+  const auto n = for_each_json_line<T>(buffer, std::forward<F>(f), err);
+  if (err) [[unlikely]]
+    detail::throw_json_line_error(err);
+  return n;
+}
+
+// Reads the lines from a stream, e.g. an std::ifstream, block by block. Only
+// the current block and one incomplete line are held in memory.
+template <typename T, typename F>
+IGUANA_INLINE size_t for_each_json_line(std::istream &in, F &&f,
+                                        json_error &err,
+                                        size_t block_size = 1 << 20) {
+  err = {};
+  detail::json_lines_reader<T, F> reader(f);
+  std::string buf;
+  size_t base = 0; // offset of buf in the stream
+  while (in) {
+    const size_t kept = buf.size();
+    buf.resize(kept + block_size);
+    in.read(buf.data() + kept, static_cast<std::streamsize>(block_size));
+    buf.resize(kept + static_cast<size_t>(in.gcount()));
+    const char *rest =
+        reader.parse_lines(buf.data(), buf.data() + buf.size(), base, err);
+    if (rest == nullptr)
+      return reader.count();
+    const auto consumed = static_cast<size_t>(rest - buf.data());
+    buf.erase(0, consumed);
+    base += consumed;
+  }
+  reader.parse(buf.data(), buf.data() + buf.size(), base, err);
+  return reader.count();
+}
+
+template <typename T, typename F>
+IGUANA_INLINE size_t for_each_json_line(std::istream &in, F &&f,
+                                        std::error_code &ec,
+                                        size_t block_size = 1 << 20) {
+  json_error err;
+  const auto n =
+      for_each_json_line<T>(in, std::forward<F>(f), err, block_size);
+  ec = iguana::make_error_code(err);
+  return n;
+}
+
+template <typename T, typename F>
+IGUANA_INLINE size_t for_each_json_line(std::istream &in, F &&f) {
+  json_error err;
+  const auto n = for_each_json_line<T>(in, std::forward<F>(f), err);
+  if (err) [[unlikely]]
+    detail::throw_json_line_error(err);
+  return n;
+}
+
+// Writes every element of range as one line of json.
+template <typename Range, sink_t Stream>
+IGUANA_INLINE void to_json_lines(const Range &range, Stream &s) {
+  for (const auto &value : range) {
+    to_json(value, s);
+    s.push_back('\n');
+  }
+}
+
+} // namespace iguana
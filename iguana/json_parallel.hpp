@@ -0,0 +1,331 @@
+#pragma once
+#include <algorithm>
+#include <exception>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "detail/simd.hpp"
+#include "json_lines.hpp"
+#include "json_reader.hpp"
+
+namespace iguana {
+
+namespace detail {
+// below this many bytes per thread the input is parsed on fewer threads
+constexpr inline size_t parallel_min_chunk = 1 << 20;
+
+IGUANA_INLINE size_t parallel_threads(size_t size, size_t threads) {
+  if (threads == 0) {
+    threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+  }
+  return (std::clamp)(size / parallel_min_chunk, size_t{1}, threads);
+}
+
+// Runs f(0) ... f(n - 1) on n threads, f(0) on the calling one. The calls a
+// thread can't be started for run on the calling thread too. All threads are
+// joined before the first exception of f, in call order, is rethrown.
+template <typename F> void run_parallel(size_t n, const F &f) {
+  std::vector<std::exception_ptr> errors(n);
+  auto run = [&](size_t i) noexcept {
+    try {
+      f(i);
+    } catch (...) {
+      errors[i] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  size_t started = 1;
+  try {
+    threads.reserve(n - 1);
+    for (; started < n; ++started) {
+      threads.emplace_back(run, started);
+    }
+  } catch (...) {
+    // out of threads or memory, the rest runs below
+  }
+  run(0);
+  for (size_t i = started; i < n; ++i) {
+    run(i);
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  for (auto &e : errors) {
+    if (e) [[unlikely]]
+      std::rethrow_exception(e);
+  }
+}
+
+// the error that comes first in the input
+IGUANA_INLINE json_error first_error(const std::vector<json_error> &errs) {
+  json_error first;
+  for (auto &err : errs) {
+    if (err && (!first || err.offset < first.offset)) {
+      first = err;
+    }
+  }
+  return first;
+}
+
+// A run of elements of the root array: [begin, end) holds count elements
+// separated by commas, end is on the comma or ']' behind the last one.
+struct array_chunk {
+  const char *begin;
+  const char *end;
+  size_t count;
+};
+
+// One structural pass over the root array. It is cut at the first top level
+// comma behind every size / n bytes, so each chunk has whole elements.
+IGUANA_INLINE json_errc split_array(const char *it, const char *end, size_t n,
+                                    std::vector<array_chunk> &chunks) {
+  skip_ws(it, end);
+  if (auto ec = match<'['>(it, end); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  skip_ws(it, end);
+  if (it != end && *it == ']') {
+    return json_errc::ok; // no elements
+  }
+  const size_t step = static_cast<size_t>(end - it) / n + 1;
+  array_chunk chunk{it, nullptr, 0};
+  const char *cut = it + step;
+  size_t depth = 1;
+
+  // p is on a bracket, brace or comma outside of any string, true once the
+  // array is closed
+  auto on_structural = [&](const char *p) {
+    switch (*p) {
+    case '[':
+    case '{':
+      ++depth;
+      break;
+    case '}':
+      --depth;
+      break;
+    case ']':
+      if (--depth == 0) {
+        chunk.end = p;
+        ++chunk.count;
+        chunks.push_back(chunk);
+        return true;
+      }
+      break;
+    case ',':
+      if (depth == 1) {
+        ++chunk.count;
+        if (p >= cut) {
+          chunk.end = p;
+          chunks.push_back(chunk);
+          chunk = {p + 1, nullptr, 0};
+          cut = p + step;
+        }
+      }
+      break;
+    }
+    return false;
+  };
+
+  // Only the brackets are visited one by one, the top level commas between
+  // two of them are counted at once.
+  string_scanner scanner;
+  while (end - it >= 64) {
+    const simd_block64 block(it);
+    const auto strings = scanner.next(block);
+    const uint64_t outside = ~strings.in_string;
+    const uint64_t open = (block.eq('[') | block.eq('{')) & outside;
+    uint64_t brackets = (open | block.eq(']') | block.eq('}')) & outside;
+    const uint64_t commas = block.eq(',') & outside;
+    uint64_t from = ~uint64_t{0}; // the bits behind the last bracket
+    while (true) {
+      const int next = brackets ? std::countr_zero(brackets) : 64;
+      if (depth == 1) {
+        uint64_t top = commas & from;
+        if (next != 64) {
+          top &= (uint64_t{1} << next) - 1;
+        }
+        if (top && it + 63 >= cut) [[unlikely]] {
+          for (; top; top &= top - 1) {
+            on_structural(it + std::countr_zero(top));
+          }
+        } else {
+          chunk.count += static_cast<size_t>(std::popcount(top));
+        }
+      }
+      if (next == 64)
+        break;
+      if (open >> next & 1) {
+        ++depth;
+      } else if (depth == 1) {
+        if (it[next] == '}') [[unlikely]]
+          return json_errc::expected_close_bracket;
+        on_structural(it + next);
+        return json_errc::ok;
+      } else {
+        --depth;
+      }
+      brackets &= brackets - 1;
+      from = ~uint64_t{0} << next << 1;
+    }
+    it += 64;
+  }
+  bool in_string = scanner.prev_in_string != 0;
+  bool escaped = scanner.prev_escaped != 0;
+  for (; it != end; ++it) {
+    if (in_string) {
+      if (escaped) {
+        escaped = false;
+      } else if (*it == '\\') {
+        escaped = true;
+      } else if (*it == '"') {
+        in_string = false;
+      }
+    } else if (*it == '"') {
+      in_string = true;
+    } else if (on_structural(it)) {
+      return json_errc::ok;
+    }
+  }
+  return json_errc::expected_close_bracket;
+}
+} // namespace detail
+
+// Parses a root array on several threads: one structural pass cuts it into
+// runs of whole elements, the runs are parsed concurrently straight into
+// their slots of value, so the elements keep their order. threads == 0 uses
+// every hardware thread, small inputs use fewer.
+template <typename T, json_view View>
+IGUANA_INLINE void from_json_parallel(std::vector<T> &value, const View &view,
+                                      json_error &err, size_t threads = 0) {
+  const char *begin = std::data(view);
+  const char *end = begin + std::size(view);
+  const size_t n = detail::parallel_threads(std::size(view), threads);
+  if (n == 1) {
+    from_json(value, view, err);
+    return;
+  }
+  std::vector<detail::array_chunk> chunks;
+  chunks.reserve(n + 1);
+  value.clear();
+  if (auto ec = detail::split_array(begin, end, n, chunks);
+      ec != json_errc::ok) [[unlikely]] {
+    err = {ec, ec == json_errc::expected_close_bracket ? std::size(view) : 0};
+    return;
+  }
+
+  std::vector<size_t> first(chunks.size() + 1, 0);
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    first[i + 1] = first[i] + chunks[i].count;
+  }
+  value.resize(first.back());
+
+  std::vector<json_error> errs(chunks.size());
+  detail::run_parallel(chunks.size(), [&](size_t i) {
+    const char *it = chunks[i].begin;
+    const char *last = chunks[i].end;
+    auto ec = json_errc::ok;
+    for (size_t idx = first[i]; idx != first[i + 1]; ++idx) {
+      if (idx != first[i]) {
+        ++it; // the comma the structural pass found
+      }
+      ec = detail::parse_item(value[idx], it, last);
+      if (ec == json_errc::ok) {
+        skip_ws(it, last);
+        if (it != last && *it != ',') [[unlikely]]
+          ec = json_errc::expected_comma;
+      }
+      if (ec != json_errc::ok) [[unlikely]]
+        break;
+    }
+    errs[i] = detail::make_json_error(ec, begin, it);
+  });
+  err = detail::first_error(errs);
+  if (err) [[unlikely]]
+    value.clear();
+}
+
+template <typename T, json_view View>
+IGUANA_INLINE void from_json_parallel(std::vector<T> &value, const View &view,
+                                      std::error_code &ec,
+                                      size_t threads = 0) {
+  json_error err;
+  from_json_parallel(value, view, err, threads);
+  ec = iguana::make_error_code(err);
+}
+
+template <typename T, json_view View>
+IGUANA_INLINE void from_json_parallel(std::vector<T> &value, const View &view,
+                                      size_t threads = 0) {
+  json_error err;
+  from_json_parallel(value, view, err, threads);
+  if (err) [[unlikely]]
+    throw std::runtime_error(std::string(err.message()));
+}
+
+// Parses json lines on several threads. The buffer is cut at the newlines
+// behind every size / n bytes, each run is parsed into its own vector and
+// the runs are moved into value in order.
+template <typename T, json_view View>
+IGUANA_INLINE void from_json_lines_parallel(std::vector<T> &value,
+                                            const View &view, json_error &err,
+                                            size_t threads = 0) {
+  const char *begin = std::data(view);
+  const char *end = begin + std::size(view);
+  const size_t n = detail::parallel_threads(std::size(view), threads);
+  std::vector<const char *> cuts{begin};
+  for (size_t i = 1; i < n; ++i) {
+    const char *p = begin + std::size(view) * i / n;
+    if (p < cuts.back())
+      continue;
+    p = static_cast<const char *>(
+        std::memchr(p, '\n', static_cast<size_t>(end - p)));
+    if (p == nullptr)
+      break;
+    cuts.push_back(p + 1);
+  }
+  cuts.push_back(end);
+
+  const size_t runs = cuts.size() - 1;
+  std::vector<std::vector<T>> parts(runs);
+  std::vector<json_error> errs(runs);
+  detail::run_parallel(runs, [&](size_t i) {
+    auto push = [&parts, i](T &item) { parts[i].push_back(std::move(item)); };
+    detail::json_lines_reader<T, decltype(push)> reader(push);
+    reader.parse(cuts[i], cuts[i + 1],
+                 static_cast<size_t>(cuts[i] - begin), errs[i]);
+  });
+  value.clear();
+  err = detail::first_error(errs);
+  if (err) [[unlikely]]
+    return;
+  size_t total = 0;
+  for (auto &part : parts) {
+    total += part.size();
+  }
+  value.reserve(total);
+  for (auto &part : parts) {
+    std::move(part.begin(), part.end(), std::back_inserter(value));
+  }
+}
+
+template <typename T, json_view View>
+IGUANA_INLINE void from_json_lines_parallel(std::vector<T> &value,
+                                            const View &view,
+                                            std::error_code &ec,
+                                            size_t threads = 0) {
+  json_error err;
+  from_json_lines_parallel(value, view, err, threads);
+  ec = iguana::make_error_code(err);
+}
+
+template <typename T, json_view View>
+IGUANA_INLINE void from_json_lines_parallel(std::vector<T> &value,
+                                            const View &view,
+                                            size_t threads = 0) {
+  json_error err;
+  from_json_lines_parallel(value, view, err, threads);
+  if (err) [[unlikely]]
+    throw std::runtime_error(std::string(err.message()));
+}
+
+} // namespace iguana
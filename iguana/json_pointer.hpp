@@ -0,0 +1,216 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+#include "json_document.hpp"
+
+namespace iguana {
+
+namespace detail {
+
+// RFC 6901 reference token, ~1 is '/' and ~0 is '~'
+IGUANA_INLINE json_errc decode_pointer_token(std::string_view token,
+                                             std::string &out) {
+  out.clear();
+  for (size_t i = 0; i < token.size(); ++i) {
+    if (token[i] != '~') {
+      out.push_back(token[i]);
+    } else if (i + 1 < token.size() && token[i + 1] == '0') {
+      out.push_back('~');
+      ++i;
+    } else if (i + 1 < token.size() && token[i + 1] == '1') {
+      out.push_back('/');
+      ++i;
+    } else [[unlikely]] {
+      return json_errc::invalid_pointer;
+    }
+  }
+  return json_errc::ok;
+}
+
+// array index, digits without leading zeros
+IGUANA_INLINE bool pointer_index(std::string_view token, size_t &idx) {
+  if (token.empty() || (token.size() > 1 && token[0] == '0')) {
+    return false;
+  }
+  auto [p, ec] = std::from_chars(token.data(), token.data() + token.size(), idx);
+  return ec == std::errc{} && p == token.data() + token.size();
+}
+
+// it is behind the value, moves it to the next one
+template <char Close>
+IGUANA_INLINE json_errc pointer_next(const char *&it, const char *end) {
+  skip_ws(it, end);
+  if (it == end) [[unlikely]]
+    return json_errc::unexpected_end;
+  if (*it == Close)
+    return json_errc::pointer_not_found;
+  if (auto ec = match<','>(it, end); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  skip_ws(it, end);
+  return json_errc::ok;
+}
+
+// it is on '{', on success it is on the value of the member named key
+IGUANA_INLINE json_errc pointer_member(const char *&it, const char *end,
+                                       std::string_view key) {
+  ++it;
+  skip_ws(it, end);
+  if (it == end) [[unlikely]]
+    return json_errc::unexpected_end;
+  if (*it == '}')
+    return json_errc::pointer_not_found;
+  while (true) {
+    if (auto ec = match<'"'>(it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
+    const char *start = it;
+    while (true) {
+      if (auto ec = skip_till_escape_or_qoute(it, end); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
+      if (*it == '"')
+        break;
+      it += 2;
+    }
+    std::string_view raw(start, static_cast<size_t>(it - start));
+    ++it;
+    skip_ws(it, end);
+    if (auto ec = match<':'>(it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
+    skip_ws(it, end);
+    if (it == end) [[unlikely]]
+      return json_errc::unexpected_end;
+    if (key_equals(raw, key)) {
+      return json_errc::ok;
+    }
+    skip_lazy_value(it, end);
+    if (auto ec = pointer_next<'}'>(it, end); ec != json_errc::ok)
+      return ec;
+  }
+}
+
+// it is on '[', on success it is on the element idx
+IGUANA_INLINE json_errc pointer_element(const char *&it, const char *end,
+                                        size_t idx) {
+  ++it;
+  skip_ws(it, end);
+  if (it == end) [[unlikely]]
+    return json_errc::unexpected_end;
+  if (*it == ']')
+    return json_errc::pointer_not_found;
+  for (; idx != 0; --idx) {
+    skip_lazy_value(it, end);
+    if (auto ec = pointer_next<']'>(it, end); ec != json_errc::ok)
+      return ec;
+  }
+  return json_errc::ok;
+}
+
+// Descends into the matching members and elements only, everything next to
+// the path is skipped without being parsed.
+IGUANA_INLINE json_errc seek_pointer(const char *&it, const char *end,
+                                     std::string_view pointer) {
+  skip_ws(it, end);
+  if (pointer.empty()) {
+    return json_errc::ok;
+  }
+  if (pointer[0] != '/') [[unlikely]]
+    return json_errc::invalid_pointer;
+
+  std::string key;
+  while (!pointer.empty()) {
+    pointer.remove_prefix(1);
+    const auto token = pointer.substr(0, pointer.find('/'));
+    pointer.remove_prefix(token.size());
+    if (it == end) [[unlikely]]
+      return json_errc::unexpected_end;
+
+    json_errc ec;
+    if (*it == '{') {
+      if (token.find('~') == std::string_view::npos) [[likely]] {
+        ec = pointer_member(it, end, token);
+      } else {
+        if (ec = decode_pointer_token(token, key); ec != json_errc::ok)
+          return ec;
+        ec = pointer_member(it, end, key);
+      }
+    } else if (*it == '[') {
+      size_t idx;
+      if (!pointer_index(token, idx))
+        return json_errc::pointer_not_found;
+      ec = pointer_element(it, end, idx);
+    } else {
+      return json_errc::pointer_not_found;
+    }
+    if (ec != json_errc::ok)
+      return ec;
+  }
+  return json_errc::ok;
+}
+
+} // namespace detail
+
+// The value a json pointer (RFC 6901, e.g. "/statuses/0/user/id") refers
+// to, an invalid cursor if there is none. Throws on malformed input.
+IGUANA_INLINE json_cursor at_pointer(const json_cursor &root,
+                                     std::string_view pointer) {
+  const auto buf = root.buffer();
+  const char *it = buf.data();
+  const char *end = buf.data() + buf.size();
+  auto ec = detail::seek_pointer(it, end, pointer);
+  if (ec == json_errc::pointer_not_found) {
+    return {};
+  }
+  if (ec != json_errc::ok) [[unlikely]]
+    detail::throw_json_errc(ec);
+  return {it, end};
+}
+
+IGUANA_INLINE json_cursor at_pointer(const json_document &doc,
+                                     std::string_view pointer) {
+  return at_pointer(doc.root(), pointer);
+}
+
+// Reads the value at pointer straight from the buffer, no DOM is built.
+template <typename T, json_view View>
+IGUANA_INLINE void get_at(T &value, const View &json, std::string_view pointer,
+                          json_error &err) {
+  const char *begin = std::data(json);
+  const char *it = begin;
+  const char *end = begin + std::size(json);
+  if (auto ec = detail::seek_pointer(it, end, pointer); ec != json_errc::ok)
+      [[unlikely]] {
+    err = detail::make_json_error(ec, begin, it);
+    return;
+  }
+  auto ec = detail::parse_item(value, it, end);
+  err = detail::make_json_error(ec, begin, it);
+}
+
+template <typename T, json_view View>
+IGUANA_INLINE T get_at(const View &json, std::string_view pointer,
+                       std::error_code &ec) {
+  T value{};
+  json_error err;
+  get_at(value, json, pointer, err);
+  ec = iguana::make_error_code(err);
+  return value;
+}
+
+template <typename T, json_view View>
+IGUANA_INLINE T get_at(const View &json, std::string_view pointer) {
+  T value{};
+  json_error err;
+  get_at(value, json, pointer, err);
+  if (err) [[unlikely]] {
+    if (err.code == json_errc::unknown_key) {
+      const char *it = std::data(json) + err.offset;
+      const char *end = std::data(json) + std::size(json);
+      throw std::runtime_error(detail::json_error_message(err.code, it, end));
+    }
+    throw std::runtime_error(std::string(err.message()));
+  }
+  return value;
+}
+
+} // namespace iguana
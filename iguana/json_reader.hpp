@@ -1,5 +1,6 @@
 #pragma once
 #include "detail/fast_float.h"
+#include "detail/key_index.hpp"
 #include "detail/utf.hpp"
 #include "json_util.hpp"
 #include "reflection.hpp"
@@ -7,10 +8,14 @@
 #include <filesystem>
 #include <forward_list>
 #include <fstream>
+#include <limits>
 #include <string_view>
 #include <type_traits>
+#include <utility>
 
 #include "error_code.h"
+#include "mmap_file.hpp"
+#include "padded_string.hpp"
 #include "value.hpp"
 
 namespace iguana {
@@ -124,20 +129,126 @@ template <class T>
 concept non_refletable = container<T> || c_array<T> || tuple<T> ||
     optional<T> || std::is_fundamental_v<T>;
 
-template <refletable T, typename It>
-void from_json(T &value, It &&it, It &&end);
+// The members of T from_json decodes, see fields(). The members outside of
+// the mask are skipped in the input and keep their values.
+template <typename T> struct field_mask {
+  static constexpr size_t size =
+      decltype(iguana_reflect_members(std::declval<T>()))::value();
+
+  constexpr void set(size_t i) noexcept {
+    bits[i / 64] |= uint64_t{1} << i % 64;
+  }
+  constexpr bool test(size_t i) const noexcept {
+    return bits[i / 64] >> i % 64 & 1;
+  }
+
+  std::array<uint64_t, (size + 63) / 64> bits{};
+};
 
 namespace detail {
+template <typename P> struct member_class;
+template <typename C, typename M> struct member_class<M C::*> {
+  using type = C;
+};
+
+template <auto Ptr, typename P> constexpr bool same_member(P ptr) {
+  if constexpr (std::is_same_v<P, decltype(Ptr)>) {
+    return ptr == Ptr;
+  } else {
+    return false;
+  }
+}
+
+template <typename T, auto Ptr, size_t... Is>
+constexpr size_t member_index(std::index_sequence<Is...>) {
+  using M = decltype(iguana_reflect_members(std::declval<T>()));
+  size_t index = sizeof...(Is);
+  ((index = same_member<Ptr>(std::get<Is>(M::apply_impl())) ? Is : index),
+   ...);
+  return index;
+}
+
+template <typename T, auto Ptr> constexpr size_t field_index() {
+  constexpr size_t size = field_mask<T>::size;
+  constexpr size_t index =
+      member_index<T, Ptr>(std::make_index_sequence<size>{});
+  static_assert(index < size, "the member is not in the REFLECTION list");
+  return index;
+}
+
+// the object parser without a mask
+struct all_fields {
+  constexpr bool test(size_t) const noexcept { return true; }
+};
+} // namespace detail
+
+// The mask of the given members of one reflected struct, e.g.
+//   iguana::from_json(p, json, iguana::fields<&person::name>());
+template <auto Ptr, auto... Ptrs> constexpr auto fields() {
+  using T = typename detail::member_class<decltype(Ptr)>::type;
+  static_assert(
+      (std::is_same_v<T, typename detail::member_class<decltype(Ptrs)>::type> &&
+       ...),
+      "the members must belong to the same struct");
+  field_mask<T> mask;
+  mask.set(detail::field_index<T, Ptr>());
+  (mask.set(detail::field_index<T, Ptrs>()), ...);
+  return mask;
+}
+
+namespace detail {
+
+template <refletable U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end);
+
+template <num_t U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end);
+
+template <enum_type_t U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end);
 
 template <str_t U, class It>
-IGUANA_INLINE void parse_escape(U &value, It &&it, It &&end) {
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end,
+                                   bool skip = false);
+
+template <str_view_t U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end,
+                                   bool skip = false);
+
+template <fixed_array U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end);
+
+template <sequence_container U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end);
+
+template <map_container U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end);
+
+template <tuple U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end);
+
+template <bool_t U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end);
+
+template <optional U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end);
+
+template <char_t U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end);
+
+// it is behind the backslash, the decoded bytes are appended to value by
+// push_back
+template <typename U, class It>
+IGUANA_INLINE json_errc parse_escape(U &value, It &&it, It &&end) {
   if (it == end)
-    throw std::runtime_error(R"(Expected ")");
+    return json_errc::expected_quote;
   if (*it == 'u') {
     ++it;
     if (std::distance(it, end) <= 4)
-      throw std::runtime_error(R"(Expected 4 hexadecimal digits)");
-    auto code_point = parse_unicode_hex4(it);
+      return json_errc::invalid_escape;
+    unsigned code_point;
+    if (!parse_unicode_hex4(it, code_point)) [[unlikely]]
+      return json_errc::invalid_escape;
     encode_utf8(value, code_point);
   } else if (*it == 'n') {
     ++it;
@@ -158,15 +269,11 @@ IGUANA_INLINE void parse_escape(U &value, It &&it, It &&end) {
     value.push_back(*it); // add the escaped character
     ++it;
   }
-}
-
-template <refletable U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
-  from_json(value, it, end);
+  return json_errc::ok;
 }
 
 template <num_t U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end) {
   skip_ws(it, end);
 
   using T = std::remove_reference_t<U>;
@@ -175,18 +282,18 @@ IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
     if constexpr (std::is_floating_point_v<T>) {
       const auto size = std::distance(it, end);
       if (size == 0) [[unlikely]]
-        throw std::runtime_error("Failed to parse number");
+        return json_errc::invalid_number;
       const auto start = &*it;
       auto [p, ec] = fast_float::from_chars(start, start + size, value);
       if (ec != std::errc{}) [[unlikely]]
-        throw std::runtime_error("Failed to parse number");
+        return json_errc::invalid_number;
       it += (p - &*it);
     } else {
       const auto size = std::distance(it, end);
       const auto start = &*it;
       auto [p, ec] = std::from_chars(start, start + size, value);
       if (ec != std::errc{}) [[unlikely]]
-        throw std::runtime_error("Failed to parse number");
+        return json_errc::invalid_number;
       it += (p - &*it);
     }
   } else {
@@ -195,42 +302,48 @@ IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
     size_t i{};
     while (it != end && is_numeric(*it)) {
       if (i > 254) [[unlikely]]
-        throw std::runtime_error("Number is too long");
+        return json_errc::number_too_long;
       buffer[i] = *it++;
       ++i;
     }
     auto [p, ec] = fast_float::from_chars(buffer, buffer + i, num);
     if (ec != std::errc{}) [[unlikely]]
-      throw std::runtime_error("Failed to parse number");
+      return json_errc::invalid_number;
     value = static_cast<T>(num);
   }
+  return json_errc::ok;
 }
 
 template <enum_type_t U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
-  parse_item((int &)value, it, end);
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end) {
+  return parse_item((int &)value, it, end);
 }
 
 template <str_t U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end, bool skip = false) {
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end, bool skip) {
   if (!skip) {
     skip_ws(it, end);
-    match<'"'>(it, end);
+    if (auto ec = match<'"'>(it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
   }
   value.clear();
   if constexpr (std::contiguous_iterator<std::decay_t<It>>) {
     auto start = it;
     while (it < end) {
-      skip_till_escape_or_qoute(it, end);
+      if (auto ec = skip_till_escape_or_qoute(it, end); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
       if (*it == '"') {
         value.append(&*start, static_cast<size_t>(std::distance(start, it)));
         ++it;
-        return;
+        return json_errc::ok;
       } else {
         // Must be an escape
         value.append(&*start, static_cast<size_t>(std::distance(start, it)));
         ++it; // skip first escape
-        parse_escape(value, it, end);
+        if (auto ec = parse_escape(value, it, end); ec != json_errc::ok)
+            [[unlikely]]
+          return ec;
         start = it;
       }
     }
@@ -239,13 +352,15 @@ IGUANA_INLINE void parse_item(U &value, It &&it, It &&end, bool skip = false) {
       switch (*it) {
         [[unlikely]] case '\\' : {
           ++it;
-          parse_escape(value, it, end);
+          if (auto ec = parse_escape(value, it, end); ec != json_errc::ok)
+              [[unlikely]]
+            return ec;
           break;
         }
-        [[unlikely]] case ']' : { return; }
+        [[unlikely]] case ']' : { return json_errc::ok; }
         [[unlikely]] case '"' : {
           ++it;
-          return;
+          return json_errc::ok;
         }
         [[likely]] default : {
           value.push_back(*it);
@@ -254,44 +369,49 @@ IGUANA_INLINE void parse_item(U &value, It &&it, It &&end, bool skip = false) {
       }
     }
   }
+  return json_errc::ok;
 }
 
 template <str_view_t U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end, bool skip = false) {
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end, bool skip) {
   static_assert(std::contiguous_iterator<std::decay_t<It>>,
                 "must be contiguous");
   if (!skip) {
     skip_ws(it, end);
-    match<'"'>(it, end);
+    if (auto ec = match<'"'>(it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
   }
   using T = std::decay_t<U>;
   auto start = it;
   while (it < end) {
-    skip_till_escape_or_qoute(it, end);
+    if (auto ec = skip_till_escape_or_qoute(it, end); ec != json_errc::ok)
+        [[unlikely]]
+      return ec;
     if (*it == '"') {
       value = T(&*start, static_cast<size_t>(std::distance(start, it)));
       ++it;
-      return;
+      return json_errc::ok;
     }
     it += 2;
   }
-  throw std::runtime_error("Expected \""); // is needed?
+  return json_errc::expected_quote;
 }
 
 template <fixed_array U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end) {
   using T = std::remove_reference_t<U>;
   skip_ws(it, end);
 
-  match<'['>(it, end);
+  if (auto ec = match<'['>(it, end); ec != json_errc::ok) [[unlikely]]
+    return ec;
   skip_ws(it, end);
   if (it == end) {
-    throw std::runtime_error("Unexpected end");
+    return json_errc::unexpected_end;
   }
 
   if (*it == ']') [[unlikely]] {
     ++it;
-    return;
+    return json_errc::ok;
   }
 
   constexpr auto n = sizeof(T) / sizeof(decltype(std::declval<T>()[0]));
@@ -299,147 +419,170 @@ IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
   auto value_it = std::begin(value);
 
   for (size_t i = 0; i < n; ++i) {
-    parse_item(*value_it++, it, end);
+    if (auto ec = parse_item(*value_it++, it, end); ec != json_errc::ok)
+        [[unlikely]]
+      return ec;
     skip_ws(it, end);
     if (it == end) {
-      throw std::runtime_error("Unexpected end");
+      return json_errc::unexpected_end;
     }
     if (*it == ',') [[likely]] {
       ++it;
       skip_ws(it, end);
     } else if (*it == ']') {
       ++it;
-      return;
+      return json_errc::ok;
     } else [[unlikely]] {
-      throw std::runtime_error("Expected ]");
+      return json_errc::expected_close_bracket;
     }
   }
+  return json_errc::ok;
 }
 
 template <sequence_container U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end) {
   value.clear();
   skip_ws(it, end);
 
-  match<'['>(it, end);
+  if (auto ec = match<'['>(it, end); ec != json_errc::ok) [[unlikely]]
+    return ec;
   skip_ws(it, end);
   for (size_t i = 0; it != end; ++i) {
     if (*it == ']') [[unlikely]] {
       ++it;
-      return;
+      return json_errc::ok;
     }
     if (i > 0) [[likely]] {
-      match<','>(it, end);
+      if (auto ec = match<','>(it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
     }
 
-    using value_type = typename std::remove_cv_t<U>::value_type;
-    if constexpr (refletable<value_type>) {
-      from_json(value.emplace_back(), it, end);
-    } else {
-      parse_item(value.emplace_back(), it, end);
-    }
+    if (auto ec = parse_item(value.emplace_back(), it, end);
+        ec != json_errc::ok) [[unlikely]]
+      return ec;
 
     skip_ws(it, end);
   }
-  throw std::runtime_error("Expected ]");
+  return json_errc::expected_close_bracket;
 }
 
 template <map_container U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end) {
   using T = std::remove_reference_t<U>;
   using key_type = typename T::key_type;
   skip_ws(it, end);
 
-  match<'{'>(it, end);
+  if (auto ec = match<'{'>(it, end); ec != json_errc::ok) [[unlikely]]
+    return ec;
   skip_ws(it, end);
   bool first = true;
   while (it != end) {
     if (*it == '}') [[unlikely]] {
       ++it;
-      return;
+      return json_errc::ok;
     } else if (first) [[unlikely]]
       first = false;
     else [[likely]] {
-      match<','>(it, end);
+      if (auto ec = match<','>(it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
     }
 
     static thread_local std::string_view key{};
-    parse_item(key, it, end);
+    if (auto ec = parse_item(key, it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
 
     skip_ws(it, end);
-    match<':'>(it, end);
+    if (auto ec = match<':'>(it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
 
     if constexpr (str_t<key_type> || str_view_t<key_type>) {
-      parse_item(value[key_type(key)], it, end);
+      if (auto ec = parse_item(value[key_type(key)], it, end);
+          ec != json_errc::ok) [[unlikely]]
+        return ec;
     } else {
       static thread_local key_type key_value{};
-      parse_item(key_value, key.begin(), key.end());
-      parse_item(value[key_value], it, end);
+      if (auto ec = parse_item(key_value, key.begin(), key.end());
+          ec != json_errc::ok) [[unlikely]]
+        return ec;
+      if (auto ec = parse_item(value[key_value], it, end);
+          ec != json_errc::ok) [[unlikely]]
+        return ec;
     }
     skip_ws(it, end);
   }
+  return json_errc::ok;
 }
 
 template <tuple U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end) {
   skip_ws(it, end);
-  match<'['>(it, end);
+  if (auto ec = match<'['>(it, end); ec != json_errc::ok) [[unlikely]]
+    return ec;
   skip_ws(it, end);
 
+  json_errc ec = json_errc::ok;
   for_each(value, [&](auto &v, auto i) IGUANA__INLINE_LAMBDA {
     constexpr auto I = decltype(i)::value;
-    if (it == end || *it == ']') {
+    if (ec != json_errc::ok || it == end || *it == ']') {
       return;
     }
     if constexpr (I != 0) {
-      match<','>(it, end);
+      if (ec = match<','>(it, end); ec != json_errc::ok) [[unlikely]]
+        return;
       skip_ws(it, end);
     }
-    parse_item(v, it, end);
+    if (ec = parse_item(v, it, end); ec != json_errc::ok) [[unlikely]]
+      return;
     skip_ws(it, end);
   });
+  if (ec != json_errc::ok) [[unlikely]]
+    return ec;
 
-  match<']'>(it, end);
+  return match<']'>(it, end);
 }
 
 template <bool_t U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end) {
   skip_ws(it, end);
 
   if (it < end) [[likely]] {
     switch (*it) {
     case 't': {
       ++it;
-      match<"rue">(it, end);
+      if (auto ec = match<"rue">(it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
       value = true;
       break;
     }
     case 'f': {
       ++it;
-      match<"alse">(it, end);
+      if (auto ec = match<"alse">(it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
       value = false;
       break;
     }
-      [[unlikely]] default : throw std::runtime_error("Expected true or false");
+      [[unlikely]] default : return json_errc::expected_true_false;
     }
   } else [[unlikely]] {
-    throw std::runtime_error("Expected true or false");
+    return json_errc::expected_true_false;
   }
+  return json_errc::ok;
 }
 
 template <optional U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end) {
   skip_ws(it, end);
   if (it < end && *it == '"') {
     ++it;
   }
   using T = std::remove_reference_t<U>;
   if (it == end) {
-    throw std::runtime_error("Unexexpected eof");
+    return json_errc::unexpected_end;
   }
   if (*it == 'n') {
     ++it;
-    match<"ull">(it, end);
+    if (auto ec = match<"ull">(it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
     if constexpr (!std::is_pointer_v<T>) {
       value.reset();
       if (it < end && *it == '"') {
@@ -450,27 +593,32 @@ IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
     using value_type = typename T::value_type;
     value_type t;
     if constexpr (str_t<value_type> || str_view_t<value_type>) {
-      parse_item(t, it, end, true);
+      if (auto ec = parse_item(t, it, end, true); ec != json_errc::ok)
+          [[unlikely]]
+        return ec;
     } else {
-      parse_item(t, it, end);
+      if (auto ec = parse_item(t, it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
     }
 
     value = std::move(t);
   }
+  return json_errc::ok;
 }
 
 template <char_t U, class It>
-IGUANA_INLINE void parse_item(U &value, It &&it, It &&end) {
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end) {
   // TODO: this does not handle escaped chars
   skip_ws(it, end);
-  match<'"'>(it, end);
+  if (auto ec = match<'"'>(it, end); ec != json_errc::ok) [[unlikely]]
+    return ec;
   if (it == end) [[unlikely]]
-    throw std::runtime_error("Unxpected end of buffer");
+    return json_errc::unexpected_end;
   if (*it == '\\') [[unlikely]]
     if (++it == end) [[unlikely]]
-      throw std::runtime_error("Unxpected end of buffer");
+      return json_errc::unexpected_end;
   value = *it++;
-  match<'"'>(it, end);
+  return match<'"'>(it, end);
 }
 
 IGUANA_INLINE void skip_object_value(auto &&it, auto &&end) {
@@ -487,7 +635,7 @@ IGUANA_INLINE void skip_object_value(auto &&it, auto &&end) {
       skip_string(it, end);
       break;
     case '/':
-      skip_comment(it, end);
+      (void)skip_comment(it, end);
       continue;
     case ',':
     case '}':
@@ -502,99 +650,192 @@ IGUANA_INLINE void skip_object_value(auto &&it, auto &&end) {
     break;
   }
 }
-} // namespace detail
 
-template <refletable T, typename It>
-IGUANA_INLINE void from_json(T &value, It &&it, It &&end) {
+// it is behind the opening quote of a key, the key and its closing quote are
+// consumed if the key is name
+template <typename It>
+IGUANA_INLINE bool match_key(std::string_view name, It &it, It &end) {
+  const size_t n = name.size();
+  if (static_cast<size_t>(std::distance(it, end)) <= n ||
+      std::memcmp(&*it, name.data(), n) != 0 || it[n] != '"')
+    return false;
+  it += n + 1;
+  return true;
+}
+
+template <typename U, size_t I, typename It>
+json_errc parse_member(U &value, It &it, It &end) {
+  using M = decltype(iguana_reflect_members(std::declval<U>()));
+  return parse_item(value.*std::get<I>(M::apply_impl()), it, end);
+}
+
+// one parse function per member, indexed like key_index<U>
+template <typename U, typename It, size_t... Is>
+constexpr auto member_parsers(std::index_sequence<Is...>) {
+  return std::array<json_errc (*)(U &, It &, It &), sizeof...(Is)>{
+      &parse_member<U, Is, It>...};
+}
+
+// fields is all_fields or a field_mask<U>, the members it does not contain
+// are skipped
+template <typename U, typename It, typename Fields>
+json_errc parse_object(U &value, It &&it, It &&end, const Fields &fields) {
   skip_ws(it, end);
 
-  match<'{'>(it, end);
+  if (auto ec = match<'{'>(it, end); ec != json_errc::ok) [[unlikely]]
+    return ec;
   skip_ws(it, end);
+  using members = key_index<std::remove_cvref_t<U>>;
+  // producers mostly write the members in declaration order, so the key is
+  // first compared with the name of the member behind the last one
+  size_t expected = 0;
   bool first = true;
   while (it != end) {
     if (*it == '}') [[unlikely]] {
       ++it;
-      return;
+      return json_errc::ok;
     } else if (first) [[unlikely]]
       first = false;
     else [[likely]] {
-      match<','>(it, end);
-    }
-
-    if constexpr (refletable<T>) {
-      std::string_view key;
-      if constexpr (std::contiguous_iterator<std::decay_t<It>>) {
-        // skip white space and escape characters and find the string
-        skip_ws(it, end);
-        match<'"'>(it, end);
-        auto start = it;
-        skip_till_escape_or_qoute(it, end);
-        if (*it == '\\') [[unlikely]] {
-          // we dont' optimize this currently because it would increase binary
-          // size significantly with the complexity of generating escaped
-          // compile time versions of keys
-          it = start;
-          static thread_local std::string static_key{};
-          detail::parse_item(static_key, it, end, true);
-          key = static_key;
-        } else [[likely]] {
-          key = std::string_view{&*start,
-                                 static_cast<size_t>(std::distance(start, it))};
-          if (key[0] == '@') [[unlikely]] {
-            key = key.substr(1);
-          }
-          ++it;
-        }
-      } else {
+      if (auto ec = match<','>(it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
+    }
+
+    skip_ws(it, end);
+    [[maybe_unused]] auto key_start = it;
+    size_t index = members::size;
+    std::string_view key;
+    if constexpr (std::contiguous_iterator<std::decay_t<It>>) {
+      // skip white space and escape characters and find the string
+      if (auto ec = match<'"'>(it, end); ec != json_errc::ok) [[unlikely]]
+        return ec;
+      auto start = it;
+      if (expected < members::size &&
+          match_key(members::names[expected], it, end)) [[likely]] {
+        index = expected;
+      } else if (auto ec = skip_till_escape_or_qoute(it, end);
+                 ec != json_errc::ok) [[unlikely]] {
+        return ec;
+      } else if (*it == '\\') [[unlikely]] {
+        // we dont' optimize this currently because it would increase binary
+        // size significantly with the complexity of generating escaped
+        // compile time versions of keys
+        it = start;
         static thread_local std::string static_key{};
-        detail::parse_item(static_key, it, end, false);
+        if (auto ec = detail::parse_item(static_key, it, end, true);
+            ec != json_errc::ok) [[unlikely]]
+          return ec;
         key = static_key;
+      } else [[likely]] {
+        key = std::string_view{&*start,
+                               static_cast<size_t>(std::distance(start, it))};
+        if (key[0] == '@') [[unlikely]] {
+          key = key.substr(1);
+        }
+        ++it;
+      }
+    } else {
+      static thread_local std::string static_key{};
+      if (auto ec = detail::parse_item(static_key, it, end, false);
+          ec != json_errc::ok) [[unlikely]]
+        return ec;
+      key = static_key;
+      if (expected < members::size && key == members::names[expected]) {
+        index = expected;
       }
+    }
 
-      skip_ws(it, end);
-      match<':'>(it, end);
-
-      static constexpr auto frozen_map = get_iguana_struct_map<T>();
-      if constexpr (frozen_map.size() > 0) {
-        const auto &member_it = frozen_map.find(key);
-        if (member_it != frozen_map.end()) {
-          std::visit(
-              [&](auto &&member_ptr) IGUANA__INLINE_LAMBDA {
-                using V = std::decay_t<decltype(member_ptr)>;
-                if constexpr (std::is_member_pointer_v<V>) {
-                  detail::parse_item(value.*member_ptr, it, end);
-                } else {
-                  static_assert(!sizeof(V), "type not supported");
-                }
-              },
-              member_it->second);
-        } else [[unlikely]] {
+    skip_ws(it, end);
+    if (auto ec = match<':'>(it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
+
+    if constexpr (members::size > 0) {
+      using Iter = std::remove_reference_t<It>;
+      static constexpr auto parsers = member_parsers<U, Iter>(
+          std::make_index_sequence<members::size>{});
+      if (index == members::size) {
+        index = members::find(key);
+      }
+      if (index != members::size) [[likely]] {
+        auto ec = json_errc::ok;
+        if constexpr (std::is_same_v<Fields, all_fields>) {
+          ec = parsers[index](value, it, end);
+        } else if (fields.test(index)) {
+          ec = parsers[index](value, it, end);
+        } else {
+          detail::skip_object_value(it, end);
+        }
+        if (ec != json_errc::ok) [[unlikely]]
+          return ec;
+        expected = index + 1;
+      } else [[unlikely]] {
 #ifdef THROW_UNKNOWN_KEY
-          throw std::runtime_error("Unknown key: " + std::string(key));
+        it = key_start;
+        return json_errc::unknown_key;
 #else
-          detail::skip_object_value(it, end);
+        detail::skip_object_value(it, end);
 #endif
-        }
       }
     }
     skip_ws(it, end);
   }
+  return json_errc::ok;
+}
+
+template <refletable U, class It>
+IGUANA_INLINE json_errc parse_item(U &value, It &&it, It &&end) {
+  return parse_object(value, it, end, all_fields{});
+}
+
+// it points to the offending token
+template <typename It>
+IGUANA_INLINE std::string json_error_message(json_errc ec, It &&it, It &&end) {
+  if (ec == json_errc::unknown_key) {
+    std::string key;
+    (void)parse_item(key, it, end);
+    if (!key.empty() && key[0] == '@') {
+      key.erase(0, 1);
+    }
+    return "Unknown key: " + key;
+  }
+  return std::string(json_errc_message(ec));
+}
+
+template <typename It>
+IGUANA_INLINE json_error make_json_error(json_errc ec, It begin, It it) {
+  return {ec, static_cast<size_t>(std::distance(begin, it))};
+}
+} // namespace detail
+
+template <refletable T, typename It>
+IGUANA_INLINE void from_json(T &value, It &&it, It &&end) {
+  if (auto ec = detail::parse_item(value, it, end); ec != json_errc::ok)
+      [[unlikely]]
+    throw std::runtime_error(detail::json_error_message(ec, it, end));
 }
 
 template <non_refletable T, typename It>
 IGUANA_INLINE void from_json(T &value, It &&it, It &&end) {
-  detail::parse_item(value, it, end);
+  if (auto ec = detail::parse_item(value, it, end); ec != json_errc::ok)
+      [[unlikely]]
+    throw std::runtime_error(detail::json_error_message(ec, it, end));
 }
 
+// non-throwing reader, err receives the error code and the byte offset of the
+// offending token. Only malformed input is reported through err, allocating
+// the value may still throw std::bad_alloc.
 template <typename T, typename It>
-IGUANA_INLINE void from_json(T &value, It &&it, It &&end,
-                             std::error_code &ec) noexcept {
-  try {
-    from_json(value, it, end);
-    ec = {};
-  } catch (std::runtime_error &e) {
-    ec = iguana::make_error_code(e.what());
-  }
+IGUANA_INLINE void from_json(T &value, It &&it, It &&end, json_error &err) {
+  auto begin = it;
+  auto ec = detail::parse_item(value, it, end);
+  err = detail::make_json_error(ec, begin, it);
+}
+
+template <typename T, typename It>
+IGUANA_INLINE void from_json(T &value, It &&it, It &&end, std::error_code &ec) {
+  json_error err;
+  from_json(value, it, end, err);
+  ec = iguana::make_error_code(err);
 }
 
 template <typename T, json_view View>
@@ -603,14 +844,13 @@ IGUANA_INLINE void from_json(T &value, const View &view) {
 }
 
 template <typename T, json_view View>
-IGUANA_INLINE void from_json(T &value, const View &view,
-                             std::error_code &ec) noexcept {
-  try {
-    from_json(value, view);
-    ec = {};
-  } catch (std::runtime_error &e) {
-    ec = iguana::make_error_code(e.what());
-  }
+IGUANA_INLINE void from_json(T &value, const View &view, json_error &err) {
+  from_json(value, std::begin(view), std::end(view), err);
+}
+
+template <typename T, json_view View>
+IGUANA_INLINE void from_json(T &value, const View &view, std::error_code &ec) {
+  from_json(value, std::begin(view), std::end(view), ec);
 }
 
 template <typename T, json_byte Byte>
@@ -621,25 +861,137 @@ IGUANA_INLINE void from_json(T &value, const Byte *data, size_t size) {
 
 template <typename T, json_byte Byte>
 IGUANA_INLINE void from_json(T &value, const Byte *data, size_t size,
-                             std::error_code &ec) noexcept {
-  try {
-    from_json(value, data, size);
-    ec = {};
-  } catch (std::runtime_error &e) {
-    ec = iguana::make_error_code(e.what());
-  }
+                             json_error &err) {
+  std::string_view buffer(data, size);
+  from_json(value, buffer, err);
+}
+
+template <typename T, json_byte Byte>
+IGUANA_INLINE void from_json(T &value, const Byte *data, size_t size,
+                             std::error_code &ec) {
+  std::string_view buffer(data, size);
+  from_json(value, buffer, ec);
 }
 
-template <bool Is_view = false, typename It>
-void parse(jvalue &result, It &&it, It &&end);
+// Decodes only the members in mask, everything else in the input is skipped
+// without being decoded. The members outside of mask keep their values.
+template <refletable T, json_view View>
+IGUANA_INLINE void from_json(T &value, const View &view,
+                             const field_mask<T> &mask, json_error &err) {
+  auto begin = std::begin(view);
+  auto it = begin;
+  auto end = std::end(view);
+  auto ec = detail::parse_object(value, it, end, mask);
+  err = detail::make_json_error(ec, begin, it);
+}
 
-template <bool Is_view = false, typename It>
-inline void parse_array(jarray &result, It &&it, It &&end) {
+template <refletable T, json_view View>
+IGUANA_INLINE void from_json(T &value, const View &view,
+                             const field_mask<T> &mask, std::error_code &ec) {
+  json_error err;
+  from_json(value, view, mask, err);
+  ec = iguana::make_error_code(err);
+}
+
+template <refletable T, json_view View>
+IGUANA_INLINE void from_json(T &value, const View &view,
+                             const field_mask<T> &mask) {
+  auto it = std::begin(view);
+  auto end = std::end(view);
+  if (auto ec = detail::parse_object(value, it, end, mask);
+      ec != json_errc::ok) [[unlikely]]
+    throw std::runtime_error(detail::json_error_message(ec, it, end));
+}
+
+// Reads an input followed by json_padding readable bytes. Strings are then
+// scanned in whole blocks without checking for the end of the input first.
+template <typename T>
+IGUANA_INLINE void from_json_padded(T &value, padded_string_view input) {
+  from_json(value, input.begin(), input.end());
+}
+
+template <typename T>
+IGUANA_INLINE void from_json_padded(T &value, padded_string_view input,
+                                    json_error &err) {
+  from_json(value, input.begin(), input.end(), err);
+}
+
+template <typename T>
+IGUANA_INLINE void from_json_padded(T &value, padded_string_view input,
+                                    std::error_code &ec) {
+  from_json(value, input.begin(), input.end(), ec);
+}
+
+namespace detail {
+struct number_value {
+  enum kind_t : uint8_t { int64, uint64, floating } kind;
+  union {
+    int64_t i;
+    uint64_t u;
+    double d;
+  };
+};
+
+// Integer literals are accumulated directly. Only a fraction, an exponent or
+// more than 64 bits go through fast_float.
+template <typename It>
+IGUANA_INLINE json_errc parse_number(number_value &num, It &&it, It &&end) {
+  auto start = it;
+  const bool negative = *it == '-';
+  if (negative) {
+    ++it;
+  }
+  auto digits = it;
+  uint64_t v = 0;
+  bool overflow = false;
+  while (it != end && is_digit(*it)) {
+    const auto d = static_cast<uint64_t>(*it - '0');
+    if (v > (std::numeric_limits<uint64_t>::max() - d) / 10) [[unlikely]] {
+      overflow = true;
+      break;
+    }
+    v = v * 10 + d;
+    ++it;
+  }
+  if (it == digits) [[unlikely]]
+    return json_errc::invalid_number;
+
+  if (!overflow && (it == end || (*it != '.' && *it != 'e' && *it != 'E')))
+      [[likely]] {
+    if (!negative) {
+      if (v <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        num.kind = number_value::int64;
+        num.i = static_cast<int64_t>(v);
+      } else {
+        num.kind = number_value::uint64;
+        num.u = v;
+      }
+      return json_errc::ok;
+    }
+    if (v <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1) {
+      num.kind = number_value::int64;
+      num.i = static_cast<int64_t>(~v + 1);
+      return json_errc::ok;
+    }
+  }
+
+  it = start;
+  num.kind = number_value::floating;
+  return parse_item(num.d, it, end);
+}
+template <bool Is_view = false, bool Raw_number = false, typename It>
+json_errc parse_value(jvalue &result, It &&it, It &&end);
+
+template <bool Is_view = false, bool Raw_number = false, typename It>
+inline json_errc parse_array(jarray &result, It &&it, It &&end) {
   skip_ws(it, end);
-  match<'['>(it, end);
+  if (auto ec = match<'['>(it, end); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  if (it == end) [[unlikely]]
+    return json_errc::unexpected_end;
   if (*it == ']') [[unlikely]] {
     ++it;
-    return;
+    return json_errc::ok;
   }
   while (true) {
     if (it == end) {
@@ -647,25 +999,33 @@ inline void parse_array(jarray &result, It &&it, It &&end) {
     }
     result.emplace_back();
 
-    parse<Is_view>(result.back(), it, end);
+    if (auto ec = parse_value<Is_view, Raw_number>(result.back(), it, end);
+        ec != json_errc::ok) [[unlikely]]
+      return ec;
 
+    if (it == end) [[unlikely]]
+      break;
     if (*it == ']') [[unlikely]] {
       ++it;
-      return;
+      return json_errc::ok;
     }
 
-    match<','>(it, end);
+    if (auto ec = match<','>(it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
   }
-  throw std::runtime_error("Expected ]");
+  return json_errc::expected_close_bracket;
 }
 
-template <bool Is_view = false, typename It>
-inline void parse_object(jobject &result, It &&it, It &&end) {
+template <bool Is_view = false, bool Raw_number = false, typename It>
+inline json_errc parse_object(jobject &result, It &&it, It &&end) {
   skip_ws(it, end);
-  match<'{'>(it, end);
+  if (auto ec = match<'{'>(it, end); ec != json_errc::ok) [[unlikely]]
+    return ec;
+  if (it == end) [[unlikely]]
+    return json_errc::unexpected_end;
   if (*it == '}') [[unlikely]] {
     ++it;
-    return;
+    return json_errc::ok;
   }
 
   skip_ws(it, end);
@@ -675,37 +1035,50 @@ inline void parse_object(jobject &result, It &&it, It &&end) {
       break;
     }
     std::string key;
-    detail::parse_item(key, it, end);
+    if (auto ec = parse_item(key, it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
 
     auto emplaced = result.try_emplace(key);
-    if (!emplaced.second)
-      throw std::runtime_error("duplicated key " + key);
+    if (!emplaced.second) [[unlikely]]
+      return json_errc::duplicated_key;
 
-    match<':'>(it, end);
+    if (auto ec = match<':'>(it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
 
-    parse<Is_view>(emplaced.first->second, it, end);
+    if (auto ec = parse_value<Is_view, Raw_number>(emplaced.first->second, it, end);
+        ec != json_errc::ok) [[unlikely]]
+      return ec;
 
+    if (it == end) [[unlikely]]
+      break;
     if (*it == '}') [[unlikely]] {
       ++it;
-      return;
+      return json_errc::ok;
     }
 
-    match<','>(it, end);
+    if (auto ec = match<','>(it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
   }
+  return json_errc::ok;
 }
 
-template <bool Is_view, typename It>
-inline void parse(jvalue &result, It &&it, It &&end) {
+template <bool Is_view, bool Raw_number, typename It>
+inline json_errc parse_value(jvalue &result, It &&it, It &&end) {
   skip_ws(it, end);
+  if (it == end) [[unlikely]]
+    return json_errc::unexpected_end;
   switch (*it) {
   case 'n':
-    match<"null">(it, end);
+    if (auto ec = match<"null">(it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
     result.template emplace<std::nullptr_t>();
     break;
 
   case 'f':
   case 't':
-    detail::parse_item(result.template emplace<bool>(), it, end);
+    if (auto ec = parse_item(result.template emplace<bool>(), it, end);
+        ec != json_errc::ok) [[unlikely]]
+      return ec;
     break;
   case '0':
   case '1':
@@ -718,63 +1091,118 @@ inline void parse(jvalue &result, It &&it, It &&end) {
   case '8':
   case '9':
   case '-': {
-    double d{};
-    detail::parse_item(d, it, end);
-    if (static_cast<int>(d) == d)
-      result.emplace<int>(d);
-    else
-      result.emplace<double>(d);
+    if constexpr (Raw_number) {
+      static_assert(std::contiguous_iterator<std::decay_t<It>>,
+                    "raw numbers need a contiguous input");
+      auto start = it;
+      while (it != end && is_numeric(*it)) {
+        ++it;
+      }
+      result.template emplace<json_number>(json_number{std::string_view(
+          &*start, static_cast<size_t>(std::distance(start, it)))});
+      break;
+    }
+    number_value num;
+    if (auto ec = parse_number(num, it, end); ec != json_errc::ok) [[unlikely]]
+      return ec;
+    switch (num.kind) {
+    case number_value::int64:
+      if (std::in_range<int>(num.i))
+        result.template emplace<int>(static_cast<int>(num.i));
+      else
+        result.template emplace<int64_t>(num.i);
+      break;
+    case number_value::uint64:
+      result.template emplace<uint64_t>(num.u);
+      break;
+    case number_value::floating:
+      // integral values written as 1.0 or 1e3 stay int like they always did
+      if (num.d >= std::numeric_limits<int>::min() &&
+          num.d <= std::numeric_limits<int>::max() &&
+          static_cast<int>(num.d) == num.d)
+        result.template emplace<int>(static_cast<int>(num.d));
+      else
+        result.template emplace<double>(num.d);
+      break;
+    }
     break;
   }
   case '"':
     if constexpr (Is_view) {
       result.template emplace<std::string_view>();
-      detail::parse_item(std::get<std::string_view>(result), it, end);
+      if (auto ec = parse_item(std::get<std::string_view>(result), it, end);
+          ec != json_errc::ok) [[unlikely]]
+        return ec;
     } else {
       result.template emplace<std::string>();
-      detail::parse_item(std::get<std::string>(result), it, end);
+      if (auto ec = parse_item(std::get<std::string>(result), it, end);
+          ec != json_errc::ok) [[unlikely]]
+        return ec;
     }
     break;
   case '[':
     result.template emplace<jarray>();
-    parse_array<Is_view>(std::get<jarray>(result), it, end);
+    if (auto ec = parse_array<Is_view, Raw_number>(std::get<jarray>(result), it, end);
+        ec != json_errc::ok) [[unlikely]]
+      return ec;
     break;
   case '{': {
     result.template emplace<jobject>();
-    parse_object<Is_view>(std::get<jobject>(result), it, end);
+    if (auto ec = parse_object<Is_view, Raw_number>(std::get<jobject>(result), it, end);
+        ec != json_errc::ok) [[unlikely]]
+      return ec;
     break;
   }
   default:
-    throw std::runtime_error("parse failed");
+    return json_errc::unexpected_value;
   }
 
   skip_ws(it, end);
+  return json_errc::ok;
 }
+} // namespace detail
 
-template <bool Is_view = false, typename It>
-inline void parse(jvalue &result, It &&it, It &&end, std::error_code &ec) {
-  try {
-    parse<Is_view>(result, it, end);
-    ec = {};
-  } catch (const std::runtime_error &e) {
+template <bool Is_view = false, bool Raw_number = false, typename It>
+inline void parse(jvalue &result, It &&it, It &&end) {
+  if (auto ec = detail::parse_value<Is_view, Raw_number>(result, it, end);
+      ec != json_errc::ok) [[unlikely]]
+    throw std::runtime_error(std::string(json_errc_message(ec)));
+}
+
+// malformed input is reported through err, building the DOM may still throw
+// std::bad_alloc
+template <bool Is_view = false, bool Raw_number = false, typename It>
+inline void parse(jvalue &result, It &&it, It &&end, json_error &err) {
+  auto begin = it;
+  auto ec = detail::parse_value<Is_view, Raw_number>(result, it, end);
+  err = detail::make_json_error(ec, begin, it);
+  if (err) [[unlikely]]
     result.template emplace<std::nullptr_t>();
-    ec = iguana::make_error_code(e.what());
-  }
 }
 
-template <bool Is_view = false, typename T, json_view View>
+template <bool Is_view = false, bool Raw_number = false, typename It>
+inline void parse(jvalue &result, It &&it, It &&end, std::error_code &ec) {
+  json_error err;
+  parse<Is_view, Raw_number>(result, it, end, err);
+  ec = iguana::make_error_code(err);
+}
+
+template <bool Is_view = false, bool Raw_number = false, typename T,
+          json_view View>
 inline void parse(T &result, const View &view) {
-  parse<Is_view>(result, std::begin(view), std::end(view));
+  parse<Is_view, Raw_number>(result, std::begin(view), std::end(view));
 }
 
-template <bool Is_view = false, typename T, json_view View>
-inline void parse(T &result, const View &view, std::error_code &ec) noexcept {
-  try {
-    parse<Is_view>(result, view);
-    ec = {};
-  } catch (std::runtime_error &e) {
-    ec = iguana::make_error_code(e.what());
-  }
+template <bool Is_view = false, bool Raw_number = false, typename T,
+          json_view View>
+inline void parse(T &result, const View &view, json_error &err) {
+  parse<Is_view, Raw_number>(result, std::begin(view), std::end(view), err);
+}
+
+template <bool Is_view = false, bool Raw_number = false, typename T,
+          json_view View>
+inline void parse(T &result, const View &view, std::error_code &ec) {
+  parse<Is_view, Raw_number>(result, std::begin(view), std::end(view), ec);
 }
 
 template <typename T, typename It>
@@ -784,23 +1212,51 @@ IGUANA_INLINE void from_json(T &value, It &&it, It &&end) {
                             "type is not supported now!");
 }
 
-IGUANA_INLINE std::string json_file_content(const std::string &filename) {
+namespace detail {
+IGUANA_INLINE std::error_code json_file_content(const std::string &filename,
+                                                std::string &content) {
   std::error_code ec;
   uint64_t size = std::filesystem::file_size(filename, ec);
   if (ec) {
-    throw std::runtime_error("file size error " + ec.message());
+    return ec;
   }
 
   if (size == 0) {
-    throw std::runtime_error("empty file");
+    return iguana::make_error_code(json_errc::empty_file);
   }
 
-  std::string content;
   content.resize(size);
 
   std::ifstream file(filename, std::ios::binary);
   file.read(content.data(), content.size());
 
+  return {};
+}
+
+IGUANA_INLINE std::error_code json_file_content(const std::string &filename,
+                                                mmap_file &file) {
+  if (auto ec = file.open(filename); ec) {
+    return ec;
+  }
+  if (file.empty()) {
+    return iguana::make_error_code(json_errc::empty_file);
+  }
+  return {};
+}
+
+[[noreturn]] IGUANA_INLINE void throw_file_error(const std::error_code &ec) {
+  if (ec.category() == json_category()) {
+    throw std::runtime_error(ec.message());
+  }
+  throw std::runtime_error("file size error " + ec.message());
+}
+} // namespace detail
+
+IGUANA_INLINE std::string json_file_content(const std::string &filename) {
+  std::string content;
+  if (auto ec = detail::json_file_content(filename, content); ec) {
+    detail::throw_file_error(ec);
+  }
   return content;
 }
 
@@ -812,13 +1268,34 @@ IGUANA_INLINE void from_json_file(T &value, const std::string &filename) {
 
 template <typename T>
 IGUANA_INLINE void from_json_file(T &value, const std::string &filename,
-                                  std::error_code &ec) noexcept {
-  try {
-    from_json_file(value, filename);
-    ec = {};
-  } catch (std::runtime_error &e) {
-    ec = iguana::make_error_code(e.what());
+                                  std::error_code &ec) {
+  std::string content;
+  if (ec = detail::json_file_content(filename, content); ec) {
+    return;
+  }
+  from_json(value, content.begin(), content.end(), ec);
+}
+
+// Maps the file instead of copying it into a string. file owns the mapping,
+// std::string_view members of value point into it and stay valid as long as
+// file is kept open.
+template <typename T>
+IGUANA_INLINE void from_json_file(T &value, const std::string &filename,
+                                  mmap_file &file) {
+  if (auto ec = detail::json_file_content(filename, file); ec) {
+    detail::throw_file_error(ec);
+  }
+  from_json(value, file.view());
+}
+
+template <typename T>
+IGUANA_INLINE void from_json_file(T &value, const std::string &filename,
+                                  mmap_file &file,
+                                  std::error_code &ec) {
+  if (ec = detail::json_file_content(filename, file); ec) {
+    return;
   }
+  from_json(value, file.view(), ec);
 }
 
 } // namespace iguana
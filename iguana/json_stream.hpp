@@ -0,0 +1,351 @@
+#pragma once
+#include <array>
+#include <string>
+#include <string_view>
+
+#include "detail/simd.hpp"
+#include "json_reader.hpp"
+
+namespace iguana {
+
+// A push parser for a json object or array that arrives in chunks, e.g. from
+// a socket. Whenever a member of the root object or an element of the root
+// array is complete it is parsed into the value with the regular reader, so
+// only the member or element that is still incomplete is buffered. A member
+// that is a sequence container is streamed the same way, element by element.
+// Comments are not supported.
+//
+//   person p;
+//   iguana::json_stream_parser parser(p);
+//   while (auto n = read(fd, buf, sizeof(buf)); n > 0)
+//     if (auto err = parser.feed({buf, size_t(n)})) ...
+//   if (auto err = parser.finish()) ...
+template <typename T> class json_stream_parser {
+  static_assert(refletable<T> || sequence_container<T>,
+                "the root must be a reflected struct or a sequence container");
+
+public:
+  explicit json_stream_parser(T &value) : value_(value) {}
+
+  // Scans the chunk and parses everything it completes. Once an error is
+  // returned every later call returns it again.
+  json_error feed(std::string_view chunk) {
+    if (err_ || state_ == state::done) {
+      return err_;
+    }
+    compact();
+    buf_.append(chunk.data(), chunk.size());
+    scan();
+    return err_;
+  }
+
+  // the end of the input, an error unless the root value was closed
+  json_error finish() {
+    if (!err_ && state_ != state::done) {
+      err_ = {json_errc::unexpected_end, consumed_ + buf_.size()};
+    }
+    return err_;
+  }
+
+  bool done() const noexcept { return state_ == state::done; }
+
+  // bytes held for the member or element that is not complete yet
+  size_t buffered() const noexcept { return buf_.size() - seg_; }
+
+private:
+  enum class state : uint8_t { start, scan, done };
+
+  void scan() {
+    if (state_ == state::start && !begin_root())
+      return;
+    // whole 64 byte blocks are classified at once, only the brackets and
+    // commas outside of strings are visited
+    while (buf_.size() - pos_ >= 64 && !err_) {
+      detail::string_scanner scanner{escaped_ ? 1u : 0u,
+                                     in_string_ ? ~uint64_t{0} : 0};
+      const detail::simd_block64 block(buf_.data() + pos_);
+      const auto strings = scanner.next(block);
+      uint64_t structural = (block.eq('{') | block.eq('}') | block.eq('[') |
+                             block.eq(']') | block.eq(',')) &
+                            ~strings.in_string;
+      const size_t base = pos_;
+      while (structural) {
+        pos_ = base + std::countr_zero(structural);
+        if (!on_structural(buf_[pos_]))
+          return;
+        structural &= structural - 1;
+      }
+      pos_ = base + 64;
+      escaped_ = scanner.prev_escaped != 0;
+      in_string_ = scanner.prev_in_string != 0;
+    }
+    while (pos_ < buf_.size() && !err_) {
+      const char c = buf_[pos_];
+      if (in_string_) {
+        if (escaped_) {
+          escaped_ = false;
+        } else if (c == '\\') {
+          escaped_ = true;
+        } else if (c == '"') {
+          in_string_ = false;
+        }
+      } else if (c == '"') {
+        in_string_ = true;
+      } else if (!on_structural(c)) {
+        return;
+      }
+      ++pos_;
+    }
+  }
+
+  // skips the whitespace in front of the root, false until it is found
+  bool begin_root() {
+    for (; pos_ < buf_.size(); ++pos_) {
+      const char c = buf_[pos_];
+      if (static_cast<uint8_t>(c) < 33)
+        continue;
+      if (c != root_open) [[unlikely]] {
+        fail(refletable<T> ? json_errc::expected_brace
+                           : json_errc::expected_bracket,
+             pos_);
+        return false;
+      }
+      if constexpr (sequence_container<T>) {
+        value_.clear();
+      }
+      state_ = state::scan;
+      depth_ = base_ = 1;
+      seg_ = pos_++;
+      first_ = true;
+      return true;
+    }
+    return false;
+  }
+
+  // c is outside of any string, false once parsing stops
+  bool on_structural(char c) {
+    switch (c) {
+    case '[':
+      if constexpr (refletable<T>) {
+        if (depth_ == 1 && member_ == no_member) {
+          begin_member_array();
+        }
+      }
+      ++depth_;
+      break;
+    case '{':
+      ++depth_;
+      break;
+    case ',':
+      if (depth_ == base_) {
+        end_segment(false);
+      }
+      break;
+    case ']':
+    case '}':
+      if (depth_ == base_) {
+        end_segment(true);
+      }
+      --depth_;
+      break;
+    default:
+      break;
+    }
+    return !err_ && state_ != state::done;
+  }
+
+  // buf_[seg_] is the separator in front of the segment, buf_[pos_] the one
+  // behind it
+  void end_segment(bool closing) {
+    const bool empty = is_blank(seg_ + 1, pos_);
+    if (empty && !(first_ && closing) && !skip_segment_) [[unlikely]] {
+      fail(json_errc::unexpected_value, pos_);
+      return;
+    }
+    if (skip_segment_) {
+      // the rest of a member whose array was streamed
+      skip_segment_ = false;
+      if (!empty) [[unlikely]] {
+        fail(closing ? json_errc::expected_close_brace
+                     : json_errc::expected_comma,
+             pos_);
+        return;
+      }
+    } else if (!empty) {
+      if (depth_ == 2) {
+        parse_member_element();
+      } else if constexpr (refletable<T>) {
+        parse_member();
+      } else {
+        parse_element(value_.emplace_back());
+      }
+      if (err_)
+        return;
+    }
+    first_ = !closing ? false : first_;
+    seg_ = pos_;
+    if (!closing)
+      return;
+    if (depth_ == 2) {
+      // the streamed array of a member is closed
+      base_ = 1;
+      member_ = no_member;
+      skip_segment_ = true;
+      first_ = false;
+    } else {
+      state_ = state::done;
+      seg_ = ++pos_;
+    }
+  }
+
+  // the segment is one member, it is parsed as the object {"key":value}
+  void parse_member() {
+    buf_[seg_] = '{';
+    buf_[pos_] = '}';
+    const char *it = buf_.data() + seg_;
+    const char *end = buf_.data() + pos_ + 1;
+    auto ec = detail::parse_item(value_, it, end);
+    if (ec == json_errc::ok && it != end) [[unlikely]]
+      ec = json_errc::expected_comma;
+    if (ec != json_errc::ok) [[unlikely]]
+      fail(ec, static_cast<size_t>(it - buf_.data()));
+  }
+
+  template <typename U> void parse_element(U &element) {
+    const char *it = buf_.data() + seg_ + 1;
+    const char *end = buf_.data() + pos_;
+    auto ec = detail::parse_item(element, it, end);
+    if (ec == json_errc::ok) {
+      skip_ws(it, end);
+      if (it != end) [[unlikely]]
+        ec = json_errc::expected_comma;
+    }
+    if (ec != json_errc::ok) [[unlikely]]
+      fail(ec, static_cast<size_t>(it - buf_.data()));
+  }
+
+  // the streamed array member is found by its index, through a table of one
+  // function per member
+  void parse_member_element() {
+    if constexpr (refletable<T>) {
+      static constexpr auto parsers = element_parsers(
+          std::make_index_sequence<detail::key_index<T>::size>{});
+      (this->*parsers[member_])();
+    }
+  }
+
+  template <size_t I> auto &member() {
+    using M = decltype(iguana_reflect_members(std::declval<T>()));
+    return value_.*std::get<I>(M::apply_impl());
+  }
+
+  // clears the member I, false if it is no sequence container to stream
+  template <size_t I> bool begin_member() {
+    if constexpr (sequence_container<
+                      std::remove_cvref_t<decltype(member<I>())>>) {
+      member<I>().clear();
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  template <size_t I> void parse_element_of() {
+    if constexpr (sequence_container<
+                      std::remove_cvref_t<decltype(member<I>())>>) {
+      parse_element(member<I>().emplace_back());
+    }
+  }
+
+  template <size_t... Is>
+  static constexpr auto member_beginners(std::index_sequence<Is...>) {
+    return std::array<bool (json_stream_parser::*)(), sizeof...(Is)>{
+        &json_stream_parser::begin_member<Is>...};
+  }
+
+  template <size_t... Is>
+  static constexpr auto element_parsers(std::index_sequence<Is...>) {
+    return std::array<void (json_stream_parser::*)(), sizeof...(Is)>{
+        &json_stream_parser::parse_element_of<Is>...};
+  }
+
+  // buf_[pos_] is a '[' in the root object. When it opens the value of a
+  // sequence container member, the elements are streamed one by one.
+  void begin_member_array() {
+    const char *it = buf_.data() + seg_ + 1;
+    const char *end = buf_.data() + pos_;
+    skip_ws(it, end);
+    if (it == end || *it != '"')
+      return;
+    const char *key_start = ++it;
+    while (it != end && *it != '"' && *it != '\\') {
+      ++it;
+    }
+    if (it == end || *it != '"')
+      return;
+    std::string_view key(key_start, static_cast<size_t>(it - key_start));
+    ++it;
+    skip_ws(it, end);
+    if (it == end || *it != ':')
+      return;
+    ++it;
+    skip_ws(it, end);
+    if (it != end)
+      return;
+    if (!key.empty() && key[0] == '@') {
+      key = key.substr(1);
+    }
+    using members = detail::key_index<T>;
+    const size_t index = members::find(key);
+    if (index == members::size)
+      return;
+    static constexpr auto beginners =
+        member_beginners(std::make_index_sequence<members::size>{});
+    if ((this->*beginners[index])()) {
+      member_ = index;
+      base_ = 2;
+      seg_ = pos_;
+      first_ = true;
+    }
+  }
+
+  bool is_blank(size_t first, size_t last) const noexcept {
+    for (; first != last; ++first) {
+      if (static_cast<uint8_t>(buf_[first]) >= 33)
+        return false;
+    }
+    return true;
+  }
+
+  void fail(json_errc ec, size_t pos) noexcept { err_ = {ec, consumed_ + pos}; }
+
+  // drops the parsed bytes once they are the larger part of the buffer
+  void compact() {
+    if (seg_ == 0 || seg_ < buf_.size() / 2)
+      return;
+    buf_.erase(0, seg_);
+    consumed_ += seg_;
+    pos_ -= seg_;
+    seg_ = 0;
+  }
+
+  static constexpr char root_open = refletable<T> ? '{' : '[';
+  static constexpr size_t no_member = static_cast<size_t>(-1);
+
+  T &value_;
+  std::string buf_;
+  size_t pos_ = 0;       // next byte to scan
+  size_t seg_ = 0;       // separator in front of the current segment
+  size_t consumed_ = 0;  // bytes dropped from the front of buf_
+  size_t depth_ = 0;
+  size_t base_ = 0;      // depth whose separators end a segment
+  state state_ = state::start;
+  bool in_string_ = false;
+  bool escaped_ = false;
+  bool first_ = true;        // no segment ended at base_ yet
+  bool skip_segment_ = false;
+  size_t member_ = no_member; // index of the member streamed at depth 2
+  json_error err_;
+};
+
+} // namespace iguana
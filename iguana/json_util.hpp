@@ -4,10 +4,16 @@
 #pragma once
 
 #include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
 #include <stdexcept>
 #include <string_view>
 
 #include "define.h"
+#include "detail/simd.hpp"
+#include "error_code.h"
 
 namespace iguana {
 template <size_t N> struct string_literal {
@@ -23,24 +29,116 @@ template <size_t N> struct string_literal {
   constexpr const std::string_view sv() const noexcept { return {value, size}; }
 };
 
-template <char c> IGUANA_INLINE void match(auto &&it, auto &&end) {
+// Readable bytes a padded input guarantees behind its end.
+constexpr inline size_t json_padding = 64;
+
+// A pointer into an input that is followed by json_padding readable bytes,
+// see from_json_padded. It is a plain contiguous iterator, the helpers below
+// use its type to load whole blocks without checking the end first.
+class padded_iterator {
+public:
+  using iterator_concept = std::contiguous_iterator_tag;
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = char;
+  using element_type = const char;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const char *;
+  using reference = const char &;
+
+  padded_iterator() = default;
+  explicit padded_iterator(const char *p) noexcept : p_(p) {}
+
+  IGUANA_INLINE reference operator*() const noexcept { return *p_; }
+  IGUANA_INLINE pointer operator->() const noexcept { return p_; }
+  IGUANA_INLINE reference operator[](difference_type n) const noexcept {
+    return p_[n];
+  }
+
+  IGUANA_INLINE padded_iterator &operator++() noexcept {
+    ++p_;
+    return *this;
+  }
+  IGUANA_INLINE padded_iterator operator++(int) noexcept {
+    return padded_iterator(p_++);
+  }
+  IGUANA_INLINE padded_iterator &operator--() noexcept {
+    --p_;
+    return *this;
+  }
+  IGUANA_INLINE padded_iterator operator--(int) noexcept {
+    return padded_iterator(p_--);
+  }
+  IGUANA_INLINE padded_iterator &operator+=(difference_type n) noexcept {
+    p_ += n;
+    return *this;
+  }
+  IGUANA_INLINE padded_iterator &operator-=(difference_type n) noexcept {
+    p_ -= n;
+    return *this;
+  }
+  IGUANA_INLINE friend padded_iterator operator+(padded_iterator it,
+                                                 difference_type n) noexcept {
+    return it += n;
+  }
+  IGUANA_INLINE friend padded_iterator operator+(difference_type n,
+                                                 padded_iterator it) noexcept {
+    return it += n;
+  }
+  IGUANA_INLINE friend padded_iterator operator-(padded_iterator it,
+                                                 difference_type n) noexcept {
+    return it -= n;
+  }
+  IGUANA_INLINE friend difference_type operator-(padded_iterator a,
+                                                 padded_iterator b) noexcept {
+    return a.p_ - b.p_;
+  }
+  friend bool operator==(padded_iterator, padded_iterator) = default;
+  friend auto operator<=>(padded_iterator, padded_iterator) = default;
+
+private:
+  const char *p_ = nullptr;
+};
+
+template <typename It>
+concept padded_input = std::same_as<std::decay_t<It>, padded_iterator>;
+
+template <char c> constexpr json_errc expected_errc() noexcept {
+  switch (c) {
+  case '"':
+    return json_errc::expected_quote;
+  case ':':
+    return json_errc::expected_colon;
+  case ',':
+    return json_errc::expected_comma;
+  case '{':
+    return json_errc::expected_brace;
+  case '}':
+    return json_errc::expected_close_brace;
+  case '[':
+    return json_errc::expected_bracket;
+  case ']':
+    return json_errc::expected_close_bracket;
+  default:
+    return json_errc::unexpected_value;
+  }
+}
+
+template <char c>
+[[nodiscard]] IGUANA_INLINE json_errc match(auto &&it, auto &&end) {
   if (it == end || *it != c) [[unlikely]] {
-    static constexpr char b[] = {c, '\0'};
-    //         static constexpr auto error = concat_arrays("Expected:", b);
-    std::string error = std::string("Expected:").append(b);
-    throw std::runtime_error(error);
+    return expected_errc<c>();
   } else [[likely]] {
     ++it;
+    return json_errc::ok;
   }
 }
 
-template <string_literal str> IGUANA_INLINE void match(auto &&it, auto &&end) {
+template <string_literal str>
+[[nodiscard]] IGUANA_INLINE json_errc match(auto &&it, auto &&end) {
+  // checked on padded input too, the padding may hold the rest of a literal
   const auto n = static_cast<size_t>(std::distance(it, end));
   if (n < str.size) [[unlikely]] {
-    // TODO: compile time generate this message, currently borken with
-    // MSVC
-    static constexpr auto error = "Unexpected end of buffer. Expected:";
-    throw std::runtime_error(error);
+    return json_errc::unexpected_end;
   }
   size_t i{};
   // clang and gcc will vectorize this loop
@@ -48,17 +146,16 @@ template <string_literal str> IGUANA_INLINE void match(auto &&it, auto &&end) {
     i += *it != *c;
   }
   if (i != 0) [[unlikely]] {
-    // TODO: compile time generate this message, currently borken with
-    // MSVC
-    static constexpr auto error = "Expected: ";
-    throw std::runtime_error(error);
+    return json_errc::invalid_literal;
   }
+  return json_errc::ok;
 }
 
-IGUANA_INLINE void skip_comment(auto &&it, auto &&end) {
+// it points to the leading '/', it is always advanced
+[[nodiscard]] IGUANA_INLINE json_errc skip_comment(auto &&it, auto &&end) {
   ++it;
   if (it == end) [[unlikely]]
-    throw std::runtime_error("Unexpected end, expected comment");
+    return json_errc::unexpected_end;
   else if (*it == '/') {
     while (++it != end && *it != '\n')
       ;
@@ -74,16 +171,27 @@ IGUANA_INLINE void skip_comment(auto &&it, auto &&end) {
       }
     }
   } else [[unlikely]]
-    throw std::runtime_error("Expected / or * after /");
+    return json_errc::invalid_comment;
+  return json_errc::ok;
 }
 
+// a malformed comment is left in place, the next token check reports it
 IGUANA_INLINE void skip_ws(auto &&it, auto &&end) {
+  if constexpr (padded_input<decltype(it)>) {
+    // most tokens follow each other directly, *end is readable
+    if (static_cast<uint8_t>(*it) >= 33 && *it != '/') [[likely]]
+      return;
+  }
   while (it != end) {
     // assuming ascii
     if (static_cast<uint8_t>(*it) < 33) {
       ++it;
     } else if (*it == '/') {
-      skip_comment(it, end);
+      auto start = it;
+      if (skip_comment(it, end) != json_errc::ok) [[unlikely]] {
+        it = start;
+        break;
+      }
     } else {
       break;
     }
@@ -101,7 +209,8 @@ IGUANA_INLINE void skip_ws_no_comments(auto &&it, auto &&end) {
   }
 }
 
-IGUANA_INLINE void skip_till_escape_or_qoute(auto &&it, auto &&end) {
+[[nodiscard]] IGUANA_INLINE json_errc skip_till_escape_or_qoute(auto &&it,
+                                                              auto &&end) {
   static_assert(std::contiguous_iterator<std::decay_t<decltype(it)>>);
 
   auto has_zero = [](uint64_t chunk) {
@@ -120,6 +229,22 @@ IGUANA_INLINE void skip_till_escape_or_qoute(auto &&it, auto &&end) {
         0b0101110001011100010111000101110001011100010111000101110001011100);
   };
 
+  if constexpr (padded_input<decltype(it)>) {
+    // whole blocks are loaded, a match in the padding is past the end
+    while (it < end) {
+      const auto i = detail::quote_or_backslash_index(&*it);
+      if (i != detail::escape_block_size) {
+        it += i;
+        if (it < end) [[likely]]
+          return json_errc::ok;
+        break;
+      }
+      it += detail::escape_block_size;
+    }
+    it = end;
+    return json_errc::expected_quote;
+  }
+
   if (std::distance(it, end) >= 7) [[likely]] {
     const auto end_m7 = end - 7;
     for (; it < end_m7; it += 8) {
@@ -127,7 +252,7 @@ IGUANA_INLINE void skip_till_escape_or_qoute(auto &&it, auto &&end) {
       uint64_t test = has_qoute(chunk) | has_escape(chunk);
       if (test != 0) {
         it += (std::countr_zero(test) >> 3);
-        return;
+        return json_errc::ok;
       }
     }
   }
@@ -137,15 +262,32 @@ IGUANA_INLINE void skip_till_escape_or_qoute(auto &&it, auto &&end) {
     switch (*it) {
     case '\\':
     case '"':
-      return;
+      return json_errc::ok;
     }
     ++it;
   }
-  throw std::runtime_error("Expected \"");
+  return json_errc::expected_quote;
 }
 
 IGUANA_INLINE void skip_string(auto &&it, auto &&end) noexcept {
   ++it;
+  if constexpr (std::contiguous_iterator<std::decay_t<decltype(it)>>) {
+    while (end - it >= static_cast<std::ptrdiff_t>(detail::escape_block_size)) {
+      const auto i = detail::quote_or_backslash_index(&*it);
+      if (i == detail::escape_block_size) {
+        it += detail::escape_block_size;
+        continue;
+      }
+      it += i;
+      if (*it == '"') {
+        ++it;
+        return;
+      }
+      if (++it == end) [[unlikely]]
+        return;
+      ++it; // the escaped byte
+    }
+  }
   while (it < end) {
     if (*it == '"') {
       ++it;
@@ -157,24 +299,22 @@ IGUANA_INLINE void skip_string(auto &&it, auto &&end) noexcept {
 }
 
 template <char open, char close>
-IGUANA_INLINE void skip_until_closed(auto &&it, auto &&end) {
-  ++it;
-  size_t open_count = 1;
-  size_t close_count = 0;
-  while (it < end && open_count > close_count) {
+IGUANA_INLINE void skip_until_closed(auto &&it, auto &&end, size_t depth) {
+  while (it < end && depth != 0) {
     switch (*it) {
     case '/':
-      skip_comment(it, end);
+      // always advances, a malformed comment is treated as skipped
+      (void)skip_comment(it, end);
       break;
     case '"':
       skip_string(it, end);
       break;
     case open:
-      ++open_count;
+      ++depth;
       ++it;
       break;
     case close:
-      ++close_count;
+      --depth;
       ++it;
       break;
     default:
@@ -183,6 +323,62 @@ IGUANA_INLINE void skip_until_closed(auto &&it, auto &&end) {
   }
 }
 
+// it is on the opening bracket. The input is classified 64 bytes at a time,
+// brackets inside strings are masked out and a block is only looked at
+// bracket by bracket when it may close the value. From the first comment on
+// the bytes are visited one by one.
+template <char open, char close>
+IGUANA_INLINE void skip_until_closed(auto &&it, auto &&end) {
+  ++it;
+  size_t depth = 1;
+  if constexpr (std::contiguous_iterator<std::decay_t<decltype(it)>>) {
+    detail::string_scanner scanner;
+    while (it < end) {
+      const auto left = static_cast<size_t>(end - it);
+      const char *p = &*it;
+      char tail[64];
+      if (left < 64) {
+        // a zero padded copy, the zeros match nothing
+        std::memset(tail, 0, sizeof(tail));
+        std::memcpy(tail, p, left);
+        p = tail;
+      }
+      const detail::simd_block64 block(p);
+      const uint64_t outside = ~scanner.next(block).in_string;
+      const uint64_t slash = block.eq('/') & outside;
+      // the brackets in front of the first comment
+      const uint64_t live = slash ? (slash & (0 - slash)) - 1 : ~uint64_t{0};
+      const uint64_t opens = block.eq(open) & outside & live;
+      const uint64_t closes = block.eq(close) & outside & live;
+      const auto close_count = static_cast<size_t>(std::popcount(closes));
+      if (close_count < depth) [[likely]] {
+        depth += static_cast<size_t>(std::popcount(opens)) - close_count;
+      } else {
+        for (uint64_t brackets = opens | closes; brackets;
+             brackets &= brackets - 1) {
+          const int i = std::countr_zero(brackets);
+          if (opens >> i & 1) {
+            ++depth;
+          } else if (--depth == 0) {
+            it += i + 1;
+            return;
+          }
+        }
+      }
+      if (slash) [[unlikely]] {
+        it += std::countr_zero(slash);
+        break;
+      }
+      if (left <= 64) {
+        it = end;
+        return;
+      }
+      it += 64;
+    }
+  }
+  skip_until_closed<open, close>(it, end, depth);
+}
+
 IGUANA_INLINE constexpr bool is_numeric(const auto c) noexcept {
   switch (c) {
   case '0':
@@ -6,7 +6,9 @@
 #define SERIALIZE_JSON_HPP
 #include "define.h"
 #include "detail/dragonbox_to_chars.h"
+#include "detail/simd.hpp"
 #include "reflection.hpp"
+#include "sink.hpp"
 #include <math.h>
 #include <optional>
 #include <string_view>
@@ -58,12 +60,16 @@ IGUANA_INLINE void join(Stream &ss, InputIt first, InputIt last, const T &delim,
 
 template <typename Stream>
 IGUANA_INLINE void render_json_value(Stream &ss, std::nullptr_t) {
-  ss.append("null");
+  ss.append("null", 4);
 }
 
 template <typename Stream>
 IGUANA_INLINE void render_json_value(Stream &ss, bool b) {
-  ss.append(b ? "true" : "false");
+  if (b) {
+    ss.append("true", 4);
+  } else {
+    ss.append("false", 5);
+  }
 };
 
 template <typename Stream, integral_t T>
@@ -107,12 +113,81 @@ IGUANA_INLINE void render_json_value(Stream &ss, T &value) {
   ss.append(temp, n);
 }
 
-template <typename Stream, string_container_t T>
-IGUANA_INLINE void render_json_value(Stream &ss, T &&t) {
+namespace detail {
+template <typename Stream>
+IGUANA_INLINE void render_escape(Stream &ss, char c) {
+  switch (c) {
+  case '"':
+    ss.append("\\\"", 2);
+    break;
+  case '\\':
+    ss.append("\\\\", 2);
+    break;
+  case '\b':
+    ss.append("\\b", 2);
+    break;
+  case '\f':
+    ss.append("\\f", 2);
+    break;
+  case '\n':
+    ss.append("\\n", 2);
+    break;
+  case '\r':
+    ss.append("\\r", 2);
+    break;
+  case '\t':
+    ss.append("\\t", 2);
+    break;
+  default: {
+    constexpr char hex[] = "0123456789abcdef";
+    const auto u = static_cast<uint8_t>(c);
+    const char esc[6] = {'\\', 'u', '0', '0', hex[u >> 4], hex[u & 0xF]};
+    ss.append(esc, 6);
+  }
+  }
+}
+
+// Clean runs are found a vector block at a time and copied in one append,
+// only '"', '\\' and control characters are escaped.
+template <typename Stream>
+IGUANA_INLINE void render_string(Stream &ss, const char *data, size_t size) {
   ss.push_back('"');
-  ss.append(t.data(), t.size());
+  const char *run = data;
+  const char *p = data;
+  const char *const end = data + size;
+  while (true) {
+    while (static_cast<size_t>(end - p) >= escape_block_size) {
+      const auto i = json_escape_index(p);
+      p += i;
+      if (i != escape_block_size)
+        break;
+    }
+    if (const auto left = static_cast<size_t>(end - p);
+        left < escape_block_size) {
+      // the tail is scanned in a padded copy, the padding never matches
+      char tail[escape_block_size];
+      std::memset(tail, ' ', escape_block_size);
+      std::memcpy(tail, p, left);
+      p += (std::min)(json_escape_index(tail), left);
+    }
+    if (p == end)
+      break;
+    if constexpr (requires { ss.reserve_escape(); })
+      ss.reserve_escape();
+    ss.append(run, p - run);
+    render_escape(ss, *p);
+    run = ++p;
+  }
+  ss.append(run, p - run);
   ss.push_back('"');
 }
+} // namespace detail
+
+template <typename Stream, string_container_t T>
+IGUANA_INLINE void render_json_value(Stream &ss, T &&t) {
+  std::string_view str(t);
+  detail::render_string(ss, str.data(), str.size());
+}
 
 template <typename Stream>
 IGUANA_INLINE void render_json_value(Stream &ss, const char *s, size_t size) {
@@ -131,7 +206,7 @@ IGUANA_INLINE void render_key(Stream &ss, T &&t) {
   render_json_value(ss, std::forward<T>(t));
 }
 
-template <typename Stream, refletable T> void to_json(T &&t, Stream &ss);
+template <sink_t Stream, refletable T> void to_json(T &&t, Stream &ss);
 
 template <typename Stream, refletable T>
 IGUANA_INLINE void render_json_value(Stream &ss, T &&t) {
@@ -144,7 +219,7 @@ IGUANA_INLINE void render_json_value(Stream &ss, T val) {
 }
 
 template <typename Stream, typename T>
-IGUANA_INLINE void render_json_value(Stream &ss, std::optional<T> &val) {
+IGUANA_INLINE void render_json_value(Stream &ss, const std::optional<T> &val) {
   if (!val) {
     render_json_value(ss, std::string("null"));
   } else {
@@ -192,17 +267,35 @@ IGUANA_INLINE void render_json_value(Stream &ss, const T &v) {
   ss.push_back(']');
 }
 
+namespace detail {
+// The key of member I as one token, e.g. `,"name":`. The comma separating it
+// from the previous member is part of the token, the first has none.
+template <typename T, size_t I> struct json_key_token {
+  static constexpr auto name = get_name<T, I>();
+  static constexpr size_t size = name.size() + (I == 0 ? 3 : 4);
+  static constexpr std::array<char, size> value = [] {
+    std::array<char, size> token{};
+    size_t n = 0;
+    if constexpr (I != 0)
+      token[n++] = ',';
+    token[n++] = '"';
+    for (size_t i = 0; i < name.size(); ++i)
+      token[n++] = name.data()[i];
+    token[n++] = '"';
+    token[n++] = ':';
+    return token;
+  }();
+};
+} // namespace detail
+
 constexpr auto write_json_key = [](auto &s, auto i,
                                    auto &t) IGUANA__INLINE_LAMBDA {
-  s.push_back('"');
-  constexpr auto name =
-      get_name<decltype(t),
-               decltype(i)::value>(); // will be replaced by string_view later
-  s.append(name.data(), name.size());
-  s.push_back('"');
+  using token = detail::json_key_token<std::remove_cvref_t<decltype(t)>,
+                                       decltype(i)::value>;
+  s.append(token::value.data(), token::size);
 };
 
-template <typename Stream, sequence_container_t T>
+template <sink_t Stream, sequence_container_t T>
 IGUANA_INLINE void to_json(T &&v, Stream &s) {
   using U = typename std::decay_t<T>::value_type;
   s.push_back('[');
@@ -220,12 +313,12 @@ IGUANA_INLINE void to_json(T &&v, Stream &s) {
   s.push_back(']');
 }
 
-template <typename Stream, associat_container_t T>
+template <sink_t Stream, associat_container_t T>
 IGUANA_INLINE void to_json(T &&t, Stream &s) {
   render_json_value(s, std::forward<T>(t));
 }
 
-template <typename Stream, tuple_t T>
+template <sink_t Stream, tuple_t T>
 IGUANA_INLINE void to_json(T &&t, Stream &s) {
   using U = typename std::decay_t<T>;
   s.push_back('[');
@@ -245,7 +338,7 @@ IGUANA_INLINE void render_json_value(Stream &ss, const T &v) {
   to_json(v, ss);
 }
 
-template <typename Stream, refletable T>
+template <sink_t Stream, refletable T>
 IGUANA_INLINE void to_json(T &&t, Stream &s) {
   s.push_back('{');
   for_each(std::forward<T>(t),
@@ -256,19 +349,119 @@ IGUANA_INLINE void to_json(T &&t, Stream &s) {
              static_assert(Idx < Count);
 
              write_json_key(s, i, t);
-             s.push_back(':');
 
              if constexpr (!is_reflection<decltype(v)>::value) {
                render_json_value(s, t.*v);
              } else {
                to_json(t.*v, s);
              }
-
-             if (Idx < Count - 1)
-               s.push_back(',');
            });
   s.push_back('}');
 }
 
+namespace detail {
+// Writes through a raw pointer into a string grown once by json_size_hint,
+// nothing is checked per byte. The hint does not count escapes, so
+// render_string reserves room for every escape it writes (reserve_escape).
+template <typename String> class reserved_sink {
+public:
+  reserved_sink(String &s, size_t hint) : s_(s) {
+    const size_t size = s_.size();
+    s_.resize(size + hint);
+    p_ = s_.data() + size;
+    limit_ = s_.data() + s_.size();
+  }
+
+  IGUANA_INLINE void push_back(char c) noexcept { *p_++ = c; }
+  IGUANA_INLINE void append(const char *s, size_t n) noexcept {
+    std::memcpy(p_, s, n);
+    p_ += n;
+  }
+  // one escape replaces a byte by at most 6
+  IGUANA_INLINE void reserve_escape() {
+    extra_ += 5;
+    if (extra_ > static_cast<size_t>(s_.data() + s_.size() - limit_))
+        [[unlikely]] {
+      const auto written = static_cast<size_t>(p_ - s_.data());
+      const auto limit = static_cast<size_t>(limit_ - s_.data());
+      s_.resize((std::max)(s_.size() + s_.size() / 4, limit + extra_));
+      p_ = s_.data() + written;
+      limit_ = s_.data() + limit;
+    }
+  }
+
+  // trims the string to the bytes written
+  void finish() { s_.resize(static_cast<size_t>(p_ - s_.data())); }
+
+private:
+  String &s_;
+  char *p_;
+  char *limit_; // where the hinted output ends, escapes come on top
+  size_t extra_ = 0;
+};
+
+// the longest shortest representation dragonbox emits for a double
+constexpr inline size_t max_float_chars = 24;
+// int64_t min and uint64_t max both have 20 characters
+constexpr inline size_t max_integer_chars = 20;
+} // namespace detail
+
+// An upper bound of the size of the json to_json writes for t as long as no
+// string needs escaping, numbers are counted at their longest. Only the sizes
+// of strings and containers are read.
+template <typename T> size_t json_size_hint(const T &t) {
+  using U = std::remove_cvref_t<T>;
+  if constexpr (std::is_same_v<U, std::nullptr_t>) {
+    return 4;
+  } else if constexpr (std::is_same_v<U, bool>) {
+    return 5;
+  } else if constexpr (integral_t<U> || enum_t<U>) {
+    return detail::max_integer_chars;
+  } else if constexpr (float_t<U>) {
+    return detail::max_float_chars;
+  } else if constexpr (string_container_t<U>) {
+    return std::string_view(t).size() + 2;
+  } else if constexpr (is_template_instant_of<std::optional, U>::value) {
+    return t ? json_size_hint(*t) : 6;
+  } else if constexpr (refletable<U>) {
+    size_t n = 2;
+    for_each(t, [&t, &n](const auto &v, auto i) IGUANA__INLINE_LAMBDA {
+      n += detail::json_key_token<U, decltype(i)::value>::size +
+           json_size_hint(t.*v);
+    });
+    return n;
+  } else if constexpr (tuple_t<U>) {
+    size_t n = 2;
+    for_each(t, [&n](const auto &v, auto) IGUANA__INLINE_LAMBDA {
+      n += json_size_hint(v) + 1;
+    });
+    return n;
+  } else if constexpr (associat_container_t<U>) {
+    size_t n = 2;
+    for (const auto &[key, value] : t) {
+      // quoted numeric keys, a colon and a comma
+      n += json_size_hint(key) + json_size_hint(value) + 4;
+    }
+    return n;
+  } else {
+    // sequence containers and arrays
+    size_t n = 2;
+    for (const auto &v : t) {
+      n += json_size_hint(v) + 1;
+    }
+    return n;
+  }
+}
+
+// to_json with a single reservation: the output grows by json_size_hint(t)
+// once and is written with no per byte capacity checks, then trimmed to the
+// bytes actually written. Only escapes in strings may grow it again.
+template <typename String, typename T>
+IGUANA_INLINE void to_json_reserved(T &&t, String &s) {
+  detail::reserved_sink<String> sink(s, json_size_hint(t));
+  to_json(std::forward<T>(t), sink);
+  sink.finish();
+}
+
 } // namespace iguana
 #endif // SERIALIZE_JSON_HPP
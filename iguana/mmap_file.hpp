@@ -0,0 +1,170 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define IGUANA_HAS_MMAP
+#else
+#include <filesystem>
+#endif
+
+#include "define.h"
+
+namespace iguana {
+
+// A read only file mapped into memory. The mapping is private, so the bytes
+// may be modified in place (an in situ xml parse does that) without ever
+// touching the file, only the pages written to are copied. At least padding
+// zero bytes follow the content, the content is therefore always null
+// terminated and may be read past its end by up to padding bytes.
+//
+// Values parsed from the mapping may hold std::string_view members that
+// point into it, they stay valid as long as the mmap_file is alive.
+//
+// Without mmap (e.g. on windows) the file is read into an owned buffer.
+class mmap_file {
+public:
+  static constexpr size_t padding = 64;
+
+  mmap_file() = default;
+  mmap_file(const mmap_file &) = delete;
+  mmap_file &operator=(const mmap_file &) = delete;
+
+  mmap_file(mmap_file &&other) noexcept { swap(other); }
+
+  mmap_file &operator=(mmap_file &&other) noexcept {
+    if (this != &other) {
+      close();
+      swap(other);
+    }
+    return *this;
+  }
+
+  ~mmap_file() { close(); }
+
+  // Maps filename, whatever was mapped before is released first.
+  std::error_code open(const std::string &filename) {
+    close();
+#if defined(IGUANA_HAS_MMAP)
+    const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return last_error();
+    }
+    auto ec = map(fd);
+    ::close(fd);
+    return ec;
+#else
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(filename, ec);
+    if (ec) {
+      return ec;
+    }
+    std::ifstream file(filename, std::ios::binary);
+    buf_.reset(new char[size + padding]);
+    file.read(buf_.get(), static_cast<std::streamsize>(size));
+    if (static_cast<uint64_t>(file.gcount()) != size) {
+      buf_.reset();
+      return std::make_error_code(std::errc::io_error);
+    }
+    std::memset(buf_.get() + size, 0, padding);
+    data_ = buf_.get();
+    size_ = static_cast<size_t>(size);
+    return {};
+#endif
+  }
+
+  void close() noexcept {
+#if defined(IGUANA_HAS_MMAP)
+    if (mapped_ != 0) {
+      ::munmap(data_, mapped_);
+    }
+    mapped_ = 0;
+#else
+    buf_.reset();
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  bool is_open() const noexcept { return data_ != nullptr; }
+  char *data() noexcept { return data_; }
+  const char *data() const noexcept { return data_; }
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+  std::string_view view() const noexcept { return {data_, size_}; }
+
+private:
+#if defined(IGUANA_HAS_MMAP)
+  static std::error_code last_error() noexcept {
+    return std::error_code(errno, std::generic_category());
+  }
+
+  // Reserves zeroed anonymous memory for the content and the padding, then
+  // maps the file over its front. Reading a file mapping past the last page
+  // of the file faults, the anonymous pages behind it do not.
+  std::error_code map(int fd) {
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      return last_error();
+    }
+    if (S_ISDIR(st.st_mode)) {
+      return std::make_error_code(std::errc::is_a_directory);
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    const auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t mapped = (size + padding + page - 1) / page * page;
+    void *base = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+      return last_error();
+    }
+    if (size != 0) {
+      if (::mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                 fd, 0) == MAP_FAILED) {
+        auto ec = last_error();
+        ::munmap(base, mapped);
+        return ec;
+      }
+#if defined(MADV_SEQUENTIAL)
+      ::madvise(base, size, MADV_SEQUENTIAL);
+#endif
+    }
+    data_ = static_cast<char *>(base);
+    size_ = size;
+    mapped_ = mapped;
+    return {};
+  }
+#endif
+
+  void swap(mmap_file &other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+#if defined(IGUANA_HAS_MMAP)
+    std::swap(mapped_, other.mapped_);
+#else
+    std::swap(buf_, other.buf_);
+#endif
+  }
+
+  char *data_ = nullptr;
+  size_t size_ = 0;
+#if defined(IGUANA_HAS_MMAP)
+  size_t mapped_ = 0; // bytes mapped, content and padding
+#else
+  std::unique_ptr<char[]> buf_;
+#endif
+};
+
+} // namespace iguana
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+#include "json_util.hpp"
+#include "mmap_file.hpp"
+
+namespace iguana {
+
+static_assert(mmap_file::padding >= json_padding);
+
+// An owned copy of a json text followed by json_padding zero bytes, the
+// input from_json_padded needs.
+class padded_string {
+public:
+  padded_string() : padded_string(size_t{0}) {}
+
+  // size bytes to be filled through data(), e.g. by a read
+  explicit padded_string(size_t size)
+      : buf_(new char[size + json_padding]), size_(size) {
+    std::memset(buf_.get() + size, 0, json_padding);
+  }
+
+  explicit padded_string(std::string_view str) : padded_string(str.size()) {
+    std::memcpy(buf_.get(), str.data(), str.size());
+  }
+
+  padded_string(const padded_string &other)
+      : padded_string(other.view()) {}
+  padded_string &operator=(const padded_string &other) {
+    if (this != &other) {
+      *this = padded_string(other.view());
+    }
+    return *this;
+  }
+  padded_string(padded_string &&) noexcept = default;
+  padded_string &operator=(padded_string &&) noexcept = default;
+
+  char *data() noexcept { return buf_.get(); }
+  const char *data() const noexcept { return buf_.get(); }
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+  std::string_view view() const noexcept { return {buf_.get(), size_}; }
+
+private:
+  std::unique_ptr<char[]> buf_;
+  size_t size_ = 0;
+};
+
+// A json text followed by at least json_padding readable bytes. It is made
+// from a padded_string, an mmap_file or a buffer the caller vouches for.
+class padded_string_view {
+public:
+  padded_string_view(const padded_string &str) noexcept
+      : data_(str.data()), size_(str.size()) {}
+  padded_string_view(const mmap_file &file) noexcept
+      : data_(file.data()), size_(file.size()) {}
+  // data[size, size + json_padding) must be readable, its content is never
+  // taken as part of the json text
+  padded_string_view(const char *data, size_t size) noexcept
+      : data_(data), size_(size) {}
+
+  const char *data() const noexcept { return data_; }
+  size_t size() const noexcept { return size_; }
+  padded_iterator begin() const noexcept { return padded_iterator(data_); }
+  padded_iterator end() const noexcept {
+    return padded_iterator(data_ + size_);
+  }
+
+private:
+  const char *data_;
+  size_t size_;
+};
+
+} // namespace iguana
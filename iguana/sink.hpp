@@ -0,0 +1,236 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#endif
+
+#include "define.h"
+
+namespace iguana {
+
+// What to_json and to_xml write to. A sink only has to accept single bytes
+// and runs of bytes, std::string and string_stream are sinks as they are.
+template <typename S>
+concept sink_t = requires(S &s, const char *data, size_t size) {
+  s.push_back('"');
+  s.append(data, size);
+};
+
+// Writes into a caller owned buffer. Once the output does not fit anymore
+// nothing else is written and overflow() is true, the buffer then holds a
+// truncated output.
+class fixed_buffer_sink {
+public:
+  fixed_buffer_sink(char *buf, size_t capacity) noexcept
+      : buf_(buf), capacity_(capacity) {}
+
+  IGUANA_INLINE void push_back(char c) noexcept {
+    if (size_ == capacity_) [[unlikely]] {
+      overflow_ = true;
+      return;
+    }
+    buf_[size_++] = c;
+  }
+
+  IGUANA_INLINE void append(const char *data, size_t size) noexcept {
+    if (size > capacity_ - size_) [[unlikely]] {
+      overflow_ = true;
+      size = capacity_ - size_;
+    }
+    std::memcpy(buf_ + size_, data, size);
+    size_ += size;
+  }
+
+  bool overflow() const noexcept { return overflow_; }
+  const char *data() const noexcept { return buf_; }
+  size_t size() const noexcept { return size_; }
+  size_t capacity() const noexcept { return capacity_; }
+  std::string_view view() const noexcept { return {buf_, size_}; }
+
+  // reuses the buffer for the next output
+  void clear() noexcept {
+    size_ = 0;
+    overflow_ = false;
+  }
+
+private:
+  char *buf_;
+  size_t capacity_;
+  size_t size_ = 0;
+  bool overflow_ = false;
+};
+
+// Writes into a chain of fixed size chunks, nothing written is ever moved.
+// The chunks are handed to writev (or any scatter/gather api) as they are.
+class buffer_chain_sink {
+public:
+  explicit buffer_chain_sink(size_t chunk_size = 16 * 1024)
+      : chunk_size_((std::max)(chunk_size, size_t{1})) {}
+
+  IGUANA_INLINE void push_back(char c) {
+    if (pos_ == end_) [[unlikely]]
+      next_chunk();
+    *pos_++ = c;
+  }
+
+  IGUANA_INLINE void append(const char *data, size_t size) {
+    while (size > static_cast<size_t>(end_ - pos_)) [[unlikely]] {
+      const auto n = static_cast<size_t>(end_ - pos_);
+      std::memcpy(pos_, data, n);
+      data += n;
+      size -= n;
+      next_chunk();
+    }
+    std::memcpy(pos_, data, size);
+    pos_ += size;
+  }
+
+  // the written bytes, in order
+  std::vector<std::string_view> chunks() const {
+    std::vector<std::string_view> result;
+    result.reserve(chunks_.size());
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+      result.emplace_back(chunks_[i].get(), chunk_used(i));
+    }
+    return result;
+  }
+
+#if __has_include(<sys/uio.h>)
+  std::vector<iovec> iovecs() const {
+    std::vector<iovec> result;
+    result.reserve(chunks_.size());
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+      result.push_back({chunks_[i].get(), chunk_used(i)});
+    }
+    return result;
+  }
+#endif
+
+  size_t size() const noexcept {
+    return chunks_.empty() ? 0 : (chunks_.size() - 1) * chunk_size_ + used();
+  }
+
+  std::string str() const {
+    std::string result;
+    result.reserve(size());
+    for (auto chunk : chunks()) {
+      result.append(chunk);
+    }
+    return result;
+  }
+
+  // keeps the first chunk for the next output
+  void clear() noexcept {
+    chunks_.resize((std::min)(chunks_.size(), size_t{1}));
+    if (!chunks_.empty()) {
+      pos_ = chunks_[0].get();
+      end_ = pos_ + chunk_size_;
+    }
+  }
+
+private:
+  void next_chunk() {
+    chunks_.push_back(std::unique_ptr<char[]>(new char[chunk_size_]));
+    pos_ = chunks_.back().get();
+    end_ = pos_ + chunk_size_;
+  }
+
+  size_t used() const noexcept {
+    return static_cast<size_t>(pos_ - chunks_.back().get());
+  }
+
+  size_t chunk_used(size_t i) const noexcept {
+    return i + 1 == chunks_.size() ? used() : chunk_size_;
+  }
+
+  size_t chunk_size_;
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  char *pos_ = nullptr;
+  char *end_ = nullptr;
+};
+
+// Buffers the output and drains it to a file descriptor whenever flush_size
+// bytes are pending. The destructor flushes what is left. A failed write is
+// kept in error() and everything after it is dropped.
+class fd_sink {
+public:
+  explicit fd_sink(int fd, size_t flush_size = 64 * 1024)
+      : fd_(fd), flush_size_((std::max)(flush_size, size_t{1})),
+        buf_(new char[flush_size_]) {}
+
+  fd_sink(const fd_sink &) = delete;
+  fd_sink &operator=(const fd_sink &) = delete;
+
+  ~fd_sink() { flush(); }
+
+  IGUANA_INLINE void push_back(char c) {
+    if (size_ == flush_size_) [[unlikely]]
+      flush();
+    buf_[size_++] = c;
+  }
+
+  IGUANA_INLINE void append(const char *data, size_t size) {
+    while (size > flush_size_ - size_) [[unlikely]] {
+      const auto n = flush_size_ - size_;
+      std::memcpy(buf_.get() + size_, data, n);
+      size_ = flush_size_;
+      data += n;
+      size -= n;
+      flush();
+    }
+    std::memcpy(buf_.get() + size_, data, size);
+    size_ += size;
+  }
+
+  // writes the pending bytes, returns false once a write failed
+  bool flush() {
+    const char *p = buf_.get();
+    size_t left = size_;
+    size_ = 0;
+    while (left != 0 && !ec_) {
+#if defined(_WIN32)
+      const auto n = ::_write(fd_, p, static_cast<unsigned>(left));
+#else
+      const auto n = ::write(fd_, p, left);
+#endif
+      if (n < 0) {
+        if (errno != EINTR)
+          ec_ = std::error_code(errno, std::generic_category());
+        continue;
+      }
+      p += n;
+      left -= static_cast<size_t>(n);
+      written_ += static_cast<size_t>(n);
+    }
+    return !ec_;
+  }
+
+  // bytes that reached the file descriptor
+  size_t written() const noexcept { return written_; }
+  const std::error_code &error() const noexcept { return ec_; }
+
+private:
+  int fd_;
+  size_t flush_size_;
+  std::unique_ptr<char[]> buf_;
+  size_t size_ = 0;
+  size_t written_ = 0;
+  std::error_code ec_;
+};
+
+} // namespace iguana
@@ -1,4 +1,9 @@
 #pragma once
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -6,6 +11,7 @@
 #include <variant>
 #include <vector>
 
+#include "detail/fast_float.h"
 #include "error_code.h"
 
 namespace iguana {
@@ -23,28 +29,78 @@ using json_map = std::unordered_map<Key, T, Args...>;
 
 enum dom_parse_error { ok, wrong_type };
 
+// The source text of a number, kept by parse<Is_view, true> and converted on
+// access. It points into the parsed input.
+template <typename CharT> struct basic_json_number {
+  std::basic_string_view<CharT> str;
+
+  // integral or floating point, throws std::invalid_argument if the text is
+  // not exactly representable as T
+  template <typename T> T get() const {
+    std::error_code ec;
+    T value = get<T>(ec);
+    if (ec) {
+      throw std::invalid_argument("the number can't be converted");
+    }
+    return value;
+  }
+
+  template <typename T> T get(std::error_code &ec) const {
+    static_assert(std::is_same_v<CharT, char>, "only char is supported");
+    static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>);
+    T value{};
+    const char *first = str.data();
+    const char *last = str.data() + str.size();
+    if constexpr (std::is_floating_point_v<T>) {
+      auto [p, err] = fast_float::from_chars(first, last, value);
+      if (err == std::errc{} && p == last) [[likely]]
+        return value;
+    } else {
+      auto [p, err] = std::from_chars(first, last, value);
+      if (err == std::errc{} && p == last) [[likely]]
+        return value;
+    }
+    ec = std::make_error_code(std::errc::invalid_argument);
+    return T{};
+  }
+
+  bool operator==(const basic_json_number &) const = default;
+};
+
+using json_number = basic_json_number<char>;
+
+// real_type is the variant index of the value that was accessed
+inline std::error_code make_error_code(dom_errc err,
+                                       size_t real_type) noexcept;
+
 template <typename CharT>
 struct basic_json_value
     : std::variant<std::monostate, std::nullptr_t, bool, double, int,
                    std::basic_string<CharT>,
                    std::vector<basic_json_value<CharT>>,
                    json_map<std::basic_string<CharT>, basic_json_value<CharT>>,
-                   std::basic_string_view<CharT>> {
+                   std::basic_string_view<CharT>, int64_t, uint64_t,
+                   basic_json_number<CharT>> {
   using string_type = std::basic_string<CharT>;
   using string_view_type = std::basic_string_view<CharT>;
   using array_type = std::vector<basic_json_value<CharT>>;
   using object_type = json_map<string_type, basic_json_value<CharT>>;
 
+  using number_type = basic_json_number<CharT>;
+
+  // alternatives are only ever appended, the index is part of dom errors
   using base_type =
       std::variant<std::monostate, std::nullptr_t, bool, double, int,
-                   string_type, array_type, object_type, string_view_type>;
+                   string_type, array_type, object_type, string_view_type,
+                   int64_t, uint64_t, number_type>;
 
   using base_type::base_type;
 
   inline const static std::unordered_map<size_t, std::string> type_map_ = {
       {0, "undefined type"}, {1, "null type"},   {2, "bool type"},
       {3, "double type"},    {4, "int type"},    {5, "string type"},
-      {6, "array type"},     {7, "object type"}, {8, "string_view type"}};
+      {6, "array type"},     {7, "object type"}, {8, "string_view type"},
+      {9, "int64 type"},     {10, "uint64 type"}, {11, "number type"}};
 
   basic_json_value() : base_type(std::in_place_type<std::monostate>) {}
 
@@ -61,7 +117,16 @@ struct basic_json_value
   bool is_bool() const { return std::holds_alternative<bool>(*this); }
   bool is_double() const { return std::holds_alternative<double>(*this); }
   bool is_int() const { return std::holds_alternative<int>(*this); }
-  bool is_number() const { return is_double() || is_int(); }
+  bool is_int64() const { return std::holds_alternative<int64_t>(*this); }
+  bool is_uint64() const { return std::holds_alternative<uint64_t>(*this); }
+  // raw number text, see parse<Is_view, true>
+  bool is_raw_number() const {
+    return std::holds_alternative<number_type>(*this);
+  }
+  bool is_number() const {
+    return is_double() || is_int() || is_int64() || is_uint64() ||
+           is_raw_number();
+  }
   bool is_string() const { return std::holds_alternative<string_type>(*this); }
   bool is_array() const { return std::holds_alternative<array_type>(*this); }
   bool is_object() const { return std::holds_alternative<object_type>(*this); }
@@ -87,12 +152,11 @@ struct basic_json_value
   }
 
   template <typename T> T get(std::error_code &ec) const {
-    try {
-      return get<T>();
-    } catch (std::exception &e) {
-      ec = iguana::make_error_code(iguana::dom_errc::wrong_type, e.what());
-      return T{};
+    if (auto p = std::get_if<T>(&base()); p) [[likely]] {
+      return *p;
     }
+    ec = iguana::make_error_code(iguana::dom_errc::wrong_type, this->index());
+    return T{};
   }
 
   template <typename T> std::error_code get_to(T &v) const {
@@ -153,12 +217,36 @@ struct basic_json_value
   array_type to_array() const { return get<array_type>(); }
   array_type to_array(std::error_code &ec) const { return get<array_type>(ec); }
 
-  double to_double() const { return get<double>(); }
-  double to_double(std::error_code &ec) const { return get<double>(ec); }
+  // also converts the 64 bit integer alternatives and raw numbers
+  double to_double() const {
+    if (auto p = std::get_if<number_type>(&base()); p)
+      return p->template get<double>();
+    if (auto v = integer_to_double(); v)
+      return *v;
+    return get<double>();
+  }
+  double to_double(std::error_code &ec) const {
+    if (auto p = std::get_if<number_type>(&base()); p)
+      return p->template get<double>(ec);
+    if (auto v = integer_to_double(); v)
+      return *v;
+    return get<double>(ec);
+  }
 
   int to_int() const { return get<int>(); }
   int to_int(std::error_code &ec) const { return get<int>(ec); }
 
+  // any integer alternative (or raw number) whose value fits
+  int64_t to_int64() const { return to_integer<int64_t>(); }
+  int64_t to_int64(std::error_code &ec) const {
+    return to_integer<int64_t>(ec);
+  }
+
+  uint64_t to_uint64() const { return to_integer<uint64_t>(); }
+  uint64_t to_uint64(std::error_code &ec) const {
+    return to_integer<uint64_t>(ec);
+  }
+
   bool to_bool() const { return get<bool>(); }
   bool to_bool(std::error_code &ec) const { return get<bool>(ec); }
 
@@ -171,6 +259,42 @@ struct basic_json_value
   string_view_type to_string_view(std::error_code &ec) const {
     return get<string_view_type>(ec);
   }
+
+private:
+  std::optional<double> integer_to_double() const {
+    if (auto p = std::get_if<int64_t>(&base()); p)
+      return static_cast<double>(*p);
+    if (auto p = std::get_if<uint64_t>(&base()); p)
+      return static_cast<double>(*p);
+    return std::nullopt;
+  }
+
+  template <typename I> I to_integer() const {
+    std::error_code ec;
+    I value = to_integer<I>(ec);
+    if (ec) {
+      throw std::invalid_argument("the value is not a " +
+                                  std::string(std::is_signed_v<I> ? "int64"
+                                                                  : "uint64"));
+    }
+    return value;
+  }
+
+  template <typename I> I to_integer(std::error_code &ec) const {
+    auto fits = [](auto v) {
+      return std::in_range<I>(v);
+    };
+    if (auto p = std::get_if<int>(&base()); p && fits(*p))
+      return static_cast<I>(*p);
+    if (auto p = std::get_if<int64_t>(&base()); p && fits(*p))
+      return static_cast<I>(*p);
+    if (auto p = std::get_if<uint64_t>(&base()); p && fits(*p))
+      return static_cast<I>(*p);
+    if (auto p = std::get_if<number_type>(&base()); p)
+      return p->template get<I>(ec);
+    ec = iguana::make_error_code(iguana::dom_errc::wrong_type, this->index());
+    return I{};
+  }
 };
 
 template <typename CharT>
@@ -192,4 +316,61 @@ void swap(basic_json_value<CharT> &lhs, basic_json_value<CharT> &rhs) noexcept {
   lhs.swap(rhs);
 }
 
+// The value packs the dom_errc into the low 8 bits and the variant index of
+// the actual type, plus one, into the remaining bits. The type names are the
+// ones of jvalue::type_map_.
+class iguana_dom_category : public std::error_category {
+public:
+  virtual const char *name() const noexcept override {
+    return "iguana::dom_category";
+  }
+  virtual std::string message(int err_val) const override {
+    switch (static_cast<dom_errc>(err_val & 0xff)) {
+    case dom_errc::ok:
+      return "ok";
+    case dom_errc::wrong_type: {
+      const auto type = static_cast<size_t>(err_val >> 8);
+      auto it = jvalue::type_map_.find(type - 1);
+      if (type == 0 || it == jvalue::type_map_.end()) {
+        return "wrong type";
+      }
+      return std::string("wrong type, ")
+          .append("real type is ")
+          .append(it->second);
+    }
+    default:
+      return "(unrecognized error)";
+    }
+  }
+
+  std::error_condition default_error_condition(
+      int err_val) const noexcept override {
+    return std::error_condition(err_val & 0xff, *this);
+  }
+};
+
+inline iguana::iguana_dom_category &dom_category() {
+  static iguana::iguana_dom_category instance;
+  return instance;
+}
+
+inline std::error_code make_error_code(dom_errc err,
+                                       size_t real_type) noexcept {
+  if (!jvalue::type_map_.contains(real_type)) {
+    return std::error_code((int)err, dom_category());
+  }
+  return std::error_code((int)err | (int)((real_type + 1) << 8),
+                         dom_category());
+}
+
+inline std::error_code make_error_code(dom_errc err,
+                                       std::string_view real_type) noexcept {
+  for (auto &[index, name] : jvalue::type_map_) {
+    if (name == real_type) {
+      return make_error_code(err, index);
+    }
+  }
+  return std::error_code((int)err, dom_category());
+}
+
 } // namespace iguana
@@ -1,8 +1,12 @@
 #pragma once
+#include "detail/key_index.hpp"
+#include "mmap_file.hpp"
 #include "reflection.hpp"
 #include "type_traits.hpp"
+#include "xml_util.hpp"
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <functional>
 #include <msstl/charconv.hpp>
 #include <optional>
@@ -11,8 +15,16 @@
 #include <type_traits>
 
 namespace iguana {
-inline std::string g_xml_read_err;
-template <typename T> void do_read(rapidxml::xml_node<char> *node, T &&t);
+// the message of the last failed from_xml without an xml_error on this thread
+inline thread_local std::string g_xml_read_err;
+
+// why a from_xml failed
+struct xml_error {
+  std::string message; // empty on success
+  size_t offset = 0;   // where the reader stopped in the input
+
+  explicit operator bool() const noexcept { return !message.empty(); }
+};
 
 constexpr inline size_t find_underline(const char *str) {
   const char *c = str;
@@ -24,8 +36,8 @@ constexpr inline size_t find_underline(const char *str) {
   return c - str;
 }
 
+// A member without a child element keeps its value, unless it is required.
 template <typename T> inline void missing_node_handler(std::string_view name) {
-  std::cout << name << " not found\n";
   if (iguana::is_required<T>(name)) {
     std::string err = "required filed ";
     err.append(name).append(" not found!");
@@ -64,9 +76,7 @@ public:
       try {
         parse_num<T>(num, value_);
         return std::make_pair(true, static_cast<T>(num));
-      } catch (std::exception &e) {
-        g_xml_read_err = e.what();
-        std::cout << "parse num failed, reason: " << e.what() << "\n";
+      } catch (std::exception &) {
         return std::make_pair(false, T{});
       }
     } else {
@@ -102,42 +112,26 @@ private:
 };
 
 template <typename T>
-inline void parse_attribute(rapidxml::xml_node<char> *node, T &t) {
+inline void parse_attribute(T &t, std::string_view name,
+                            std::string_view value) {
   using U = std::decay_t<T>;
   static_assert(is_map_container<U>::value, "must be map container");
   using key_type = typename U::key_type;
   using value_type = typename U::mapped_type;
   static_assert(is_str_v<key_type>, " key of attribute map must be str");
-  rapidxml::xml_attribute<> *attr = node->first_attribute();
-  while (attr != nullptr) {
-    value_type value_item;
-    std::string_view value(attr->value(), attr->value_size());
-    if constexpr (is_str_v<value_type> || std::is_same_v<any_t, value_type>) {
-      value_item = value_type{value};
-    } else if constexpr (std::is_arithmetic_v<value_type> &&
-                         !std::is_same_v<bool, value_type>) {
-      parse_num<value_type>(value_item, value);
-    } else {
-      static_assert(!sizeof(value_type), "value type not supported");
-    }
-    t.emplace(key_type(attr->name(), attr->name_size()), std::move(value_item));
-    attr = attr->next_attribute();
-  }
-}
-
-inline rapidxml::xml_node<char> *
-find_cdata(const rapidxml::xml_node<char> *node) {
-  for (auto cn = node->first_node(); cn; cn = cn->next_sibling()) {
-    if (cn->type() == rapidxml::node_cdata) {
-      return cn;
-    }
+  value_type value_item;
+  if constexpr (is_str_v<value_type> || std::is_same_v<any_t, value_type>) {
+    value_item = value_type{value};
+  } else if constexpr (std::is_arithmetic_v<value_type> &&
+                       !std::is_same_v<bool, value_type>) {
+    parse_num<value_type>(value_item, value);
+  } else {
+    static_assert(!sizeof(value_type), "value type not supported");
   }
-  return nullptr;
+  t.emplace(key_type(name), std::move(value_item));
 }
 
-template <typename T>
-inline void parse_item(rapidxml::xml_node<char> *node, T &t,
-                       std::string_view value) {
+template <typename T> inline void parse_item(T &t, std::string_view value) {
   using U = std::remove_reference_t<T>;
   if constexpr (std::is_same_v<char, U>) {
     if (!value.empty())
@@ -158,151 +152,492 @@ inline void parse_item(rapidxml::xml_node<char> *node, T &t,
     }
   } else if constexpr (is_str_v<U>) {
     t = U{value};
-  } else if constexpr (is_reflection_v<U>) {
-    do_read(node, t);
-  } else if constexpr (is_std_optinal_v<U>) {
-    if (!value.empty()) {
-      using value_type = typename U::value_type;
-      value_type opt{};
-      parse_item(node, opt, value);
-      t = std::move(opt);
-    }
-  } else if constexpr (is_std_pair_v<U>) {
-    parse_item(node, t.first, value);
-    parse_attribute(node, t.second);
-  } else if constexpr (is_namespace_v<U>) {
-    using value_type = typename U::value_type;
-    value_type ns{};
-    if constexpr (is_reflection_v<value_type>) {
-      do_read(node, ns);
-    } else {
-      parse_item(node, ns, value);
-    }
-    t = T{std::move(ns)};
   } else {
     static_assert(!sizeof(T), "don't support this type!!");
   }
 }
 
-template <typename T, typename member_type>
-inline void parse_node(rapidxml::xml_node<char> *node, member_type &&t,
-                       std::string_view name) {
-  using item_type = std::decay_t<member_type>;
-  if constexpr (std::is_same_v<cdata_t, item_type>) {
-    auto c_node = find_cdata(node);
-    if (c_node) {
-      t = cdata_t(c_node->value(), c_node->value_size());
+namespace detail {
+template <typename T, size_t I>
+using xml_member_t = std::remove_cvref_t<decltype(std::declval<T &>().*
+                                                  std::get<I>(decltype(iguana_reflect_members(
+                                                      std::declval<T>()))::apply_impl()))>;
+
+template <typename T> constexpr bool is_xml_array() {
+  if constexpr (is_str_v<T> || is_map_container<T>::value) {
+    return false;
+  } else {
+    return is_container<T>::value;
+  }
+}
+
+// cdata_t, std::optional<cdata_t> or a container of cdata_t, filled from the
+// CDATA sections of the element rather than from a child element
+template <typename T> constexpr bool is_cdata_member() {
+  if constexpr (is_std_optinal_v<T>) {
+    return is_cdata_member<typename T::value_type>();
+  } else if constexpr (is_xml_array<T>()) {
+    return std::is_same_v<typename T::value_type, cdata_t>;
+  } else {
+    return std::is_same_v<T, cdata_t>;
+  }
+}
+
+// a member that is reported by missing_node_handler without a child element
+template <typename T> constexpr bool is_required_child() {
+  if constexpr (is_map_container<T>::value || is_cdata_member<T>() ||
+                is_std_optinal_v<T>) {
+    return false;
+  } else if constexpr (is_xml_array<T>()) {
+    return !is_std_optinal_v<typename T::value_type>;
+  } else {
+    return true;
+  }
+}
+
+template <typename T, typename F, size_t... Is>
+constexpr auto member_flags(F f, std::index_sequence<Is...>) {
+  return std::array<bool, sizeof...(Is)>{
+      f(std::type_identity<xml_member_t<T, Is>>{})...};
+}
+
+// The element names of the members of T, the first '_' in the name of a
+// namespace_t member is the ':' behind its prefix.
+template <typename T> struct xml_tags {
+  using M = decltype(iguana_reflect_members(std::declval<T>()));
+  static constexpr size_t size = M::value();
+  static constexpr auto seq = std::make_index_sequence<size>{};
+
+  static constexpr auto namespaces = member_flags<T>(
+      [](auto id) { return is_namespace_v<typename decltype(id)::type>; },
+      seq);
+  static constexpr auto required = member_flags<T>(
+      [](auto id) { return is_required_child<typename decltype(id)::type>(); },
+      seq);
+  static constexpr auto attributes = member_flags<T>(
+      [](auto id) {
+        return is_map_container<typename decltype(id)::type>::value;
+      },
+      seq);
+  static constexpr bool has_attributes =
+      std::find(attributes.begin(), attributes.end(), true) != attributes.end();
+  // members filled from every child of their name, the others from the first
+  static constexpr auto repeated = member_flags<T>(
+      [](auto id) {
+        using type = typename decltype(id)::type;
+        if constexpr (is_std_optinal_v<type>) {
+          return is_xml_array<typename type::value_type>();
+        } else {
+          return is_xml_array<type>();
+        }
+      },
+      seq);
+
+  static constexpr size_t length = [] {
+    size_t n = 0;
+    for (size_t i = 0; i < size; ++i) {
+      n += M::arr()[i].size();
     }
-  } else if constexpr (
-      is_std_optinal_v<item_type>) { // std::optional<std::vector<some_object>>
-    using op_value_type = typename item_type::value_type;
-    if constexpr ((!is_str_v<op_value_type> &&
-                   is_container<op_value_type>::value) ||
-                  std::is_same_v<cdata_t, op_value_type>) {
-      op_value_type op_val;
-      parse_node<T>(node, op_val, name);
-      t = std::move(op_val);
-    } else {
-      auto n = node->first_node(name.data());
-      if (n) {
-        parse_item(n, t, std::string_view(n->value(), n->value_size()));
+    return n;
+  }();
+
+  static constexpr auto chars = [] {
+    std::array<char, length> buf{};
+    size_t pos = 0;
+    for (size_t i = 0; i < size; ++i) {
+      const auto name = M::arr()[i];
+      for (size_t j = 0; j < name.size(); ++j) {
+        buf[pos + j] = name[j];
       }
+      if (namespaces[i]) {
+        buf[pos + find_underline(name.data())] = ':';
+      }
+      pos += name.size();
     }
-  } else if constexpr (!is_str_v<item_type> && is_container<item_type>::value) {
-    using value_type = typename item_type::value_type;
-    if constexpr (std::is_same_v<cdata_t, value_type>) {
-      for (auto c = node->first_node(); c; c = c->next_sibling()) {
-        if (c->type() == rapidxml::node_cdata) {
-          t.push_back(value_type(c->value(), c->value_size()));
+    return buf;
+  }();
+
+  static_assert(
+      [] {
+        for (size_t i = 0; i < size; ++i) {
+          if (namespaces[i] &&
+              find_underline(M::arr()[i].data()) >= M::arr()[i].size())
+            return false;
         }
-      }
-    } else {
-      auto n = node->first_node(name.data());
-      if (n) {
-        while (n) {
-          if (std::string_view(n->name(), n->name_size()) != name) {
-            break;
-          }
-          value_type item;
-          parse_item(n, item, std::string_view(n->value(), n->value_size()));
-          t.push_back(std::move(item));
-          n = n->next_sibling();
+        return true;
+      }(),
+      "'_' is needed in namesapce_t value name");
+
+  static constexpr auto names = [] {
+    std::array<std::string_view, size> tags{};
+    size_t pos = 0;
+    for (size_t i = 0; i < size; ++i) {
+      tags[i] = std::string_view(chars.data() + pos, M::arr()[i].size());
+      pos += M::arr()[i].size();
+    }
+    return tags;
+  }();
+
+  // the index of the member, size if there is none
+  IGUANA_INLINE static constexpr size_t find(std::string_view name) noexcept {
+    return name_index<names>::find(name);
+  }
+};
+
+template <int Flags>
+constexpr inline bool xml_translate =
+    (Flags & rapidxml::parse_no_entity_translation) == 0;
+
+// Entities are decoded in place when the input may be written to. A read only
+// input is never written to, only the std::string fields, which own their
+// text, get decoded copies, views keep the raw text.
+template <typename It>
+constexpr inline bool xml_in_situ =
+    !std::is_const_v<std::remove_reference_t<decltype(*std::declval<It>())>>;
+
+// the value in [first, last), its entities are decoded in place
+template <int Flags, typename It>
+IGUANA_INLINE std::string_view xml_value(It first, It last) {
+  if constexpr (xml_translate<Flags> && xml_in_situ<It>) {
+    if (find_xml_char(first, last, '&') != last) {
+      last = first + (decode_xml_entities(first, last, &*first) - &*first);
+    }
+  }
+  return {&*first, static_cast<size_t>(last - first)};
+}
+
+template <int Flags, typename It, typename U>
+IGUANA_INLINE void parse_xml_item(U &t, std::string_view value) {
+  if constexpr (xml_translate<Flags> && !xml_in_situ<It> &&
+                std::is_same_v<U, std::string>) {
+    t.resize(value.size());
+    const char *last = value.data() + value.size();
+    t.resize(static_cast<size_t>(
+        decode_xml_entities(value.data(), last, t.data()) - t.data()));
+  } else {
+    iguana::parse_item(t, value);
+  }
+}
+
+template <int Flags, typename It, typename Map>
+IGUANA_INLINE void parse_xml_attribute(Map &t, std::string_view name,
+                                       std::string_view value) {
+  if constexpr (xml_translate<Flags> && !xml_in_situ<It> &&
+                std::is_same_v<typename Map::mapped_type, std::string>) {
+    std::string decoded;
+    parse_xml_item<Flags, It>(decoded, value);
+    t.emplace(typename Map::key_type(name), std::move(decoded));
+  } else {
+    parse_attribute(t, name, value);
+  }
+}
+
+// The text of a leaf element, it is behind the start tag. Like rapidxml it is
+// the first run of character data, the rest of the content is skipped.
+template <int Flags, typename It>
+IGUANA_INLINE std::string_view read_xml_text(It &it, It end, bool empty) {
+  std::string_view value;
+  if (empty) {
+    return value;
+  }
+  bool found = false;
+  read_xml_content(
+      it, end,
+      [&](It first, It last) {
+        if (found)
+          return;
+        // like rapidxml, a run of nothing but whitespace is no text
+        It p = first;
+        while (p != last && is_xml_space(*p)) {
+          ++p;
         }
-      } else {
-        if constexpr (!is_std_optinal_v<value_type>) {
-          missing_node_handler<T>(name);
+        if (p == last)
+          return;
+        if constexpr ((Flags & rapidxml::parse_trim_whitespace) != 0) {
+          first = p;
+          while (is_xml_space(last[-1])) {
+            --last;
+          }
         }
-      }
+        value = xml_value<Flags>(first, last);
+        found = true;
+      },
+      [&](std::string_view) { skip_xml_element(it, end); },
+      [](std::string_view) {});
+  return value;
+}
+
+template <typename T>
+IGUANA_INLINE void add_cdata(T &t, std::string_view value, bool first) {
+  if constexpr (std::is_same_v<T, cdata_t>) {
+    if (first) {
+      t = cdata_t(value.data(), value.size());
     }
+  } else if constexpr (is_std_optinal_v<T>) {
+    if (!t.has_value()) {
+      t.emplace();
+    }
+    add_cdata(*t, value, first);
   } else {
-    auto n = node->first_node(name.data());
-    if (n) {
-      parse_item(n, t, std::string_view(n->value(), n->value_size()));
-    } else {
-      if constexpr (!is_std_optinal_v<item_type>) {
-        missing_node_handler<T>(name);
+    t.push_back(cdata_t(value.data(), value.size()));
+  }
+}
+
+template <int Flags, typename U, typename It>
+void read_element(U &t, It &it, It end);
+
+// a child element of the member t, containers get one item per element
+template <int Flags, typename U, typename It>
+IGUANA_INLINE void read_child(U &t, It &it, It end) {
+  if constexpr (is_xml_array<U>()) {
+    typename U::value_type item{};
+    read_element<Flags>(item, it, end);
+    t.push_back(std::move(item));
+  } else if constexpr (is_std_optinal_v<U>) {
+    if constexpr (is_xml_array<typename U::value_type>()) {
+      if (!t.has_value()) {
+        t.emplace();
       }
+      read_child<Flags>(*t, it, end);
+    } else {
+      read_element<Flags>(t, it, end);
     }
+  } else {
+    read_element<Flags>(t, it, end);
   }
 }
 
-template <typename T>
-inline void do_read(rapidxml::xml_node<char> *node, T &&t) {
-  static_assert(is_reflection_v<std::remove_reference_t<T>>,
-                "must be refletable object");
-  for_each(std::forward<T>(t), [&t, &node](const auto member_ptr, auto i) {
-    using member_ptr_type = std::decay_t<decltype(member_ptr)>;
-    using type_v =
-        decltype(std::declval<T>().*std::declval<decltype(member_ptr)>());
-    using item_type = std::decay_t<type_v>;
-
-    if constexpr (std::is_member_pointer_v<member_ptr_type>) {
-      using M = decltype(iguana_reflect_members(std::forward<T>(t)));
-      constexpr auto Idx = decltype(i)::value;
-      constexpr auto Count = M::value();
-      static_assert(Idx < Count);
-      constexpr auto key = M::arr()[Idx];
-      std::string_view str = key.data();
-      if constexpr (is_map_container<item_type>::value) {
-        parse_attribute(node, t.*member_ptr);
-      } else if constexpr (is_namespace_v<item_type>) {
-        constexpr auto index_ul = find_underline(key.data());
-        static_assert(index_ul < key.size(),
-                      "'_' is needed in namesapce_t value name");
-        std::string ns(key.data(), key.size());
-        ns[index_ul] = ':';
-        parse_node<T>(node, t.*member_ptr, ns);
-      } else {
-        parse_node<T>(node, t.*member_ptr, str);
+template <int Flags, typename U, size_t I, typename It>
+void read_member(U &t, It &it, It end) {
+  using M = decltype(iguana_reflect_members(std::declval<U>()));
+  using item_type = xml_member_t<U, I>;
+  if constexpr (is_map_container<item_type>::value ||
+                is_cdata_member<item_type>()) {
+    skip_xml_element(it, end); // not filled from child elements
+  } else {
+    read_child<Flags>(t.*std::get<I>(M::apply_impl()), it, end);
+  }
+}
+
+// one read function per member, indexed like xml_tags<U>
+template <int Flags, typename U, typename It, size_t... Is>
+constexpr auto member_readers(std::index_sequence<Is...>) {
+  return std::array<void (*)(U &, It &, It), sizeof...(Is)>{
+      &read_member<Flags, U, Is, It>...};
+}
+
+// It is behind the start tag. Every child element goes straight to the
+// member it names, the children are walked once and each name is looked up
+// through a compile time hash of the member names.
+template <int Flags, typename U, typename It>
+void read_object(U &t, It &it, It end, bool empty) {
+  using tags = xml_tags<U>;
+  std::array<bool, tags::size> found{};
+  if (!empty) {
+    bool first_cdata = true;
+    // the items of a container are siblings of the same name, so the name
+    // is first compared with that of the last child
+    size_t last = tags::size;
+    read_xml_content(
+        it, end, [](It, It) {},
+        [&](std::string_view name) {
+          static constexpr auto readers =
+              member_readers<Flags, U, It>(tags::seq);
+          size_t index = last;
+          if (index == tags::size || tags::names[index] != name) {
+            index = tags::find(name);
+            if (index == tags::size) {
+              skip_xml_element(it, end);
+              return;
+            }
+          }
+          if (found[index] && !tags::repeated[index]) {
+            skip_xml_element(it, end); // the first one wins, as in rapidxml
+            return;
+          }
+          readers[index](t, it, end);
+          found[index] = true;
+          last = index;
+        },
+        [&](std::string_view value) {
+          for_each(t, [&](const auto member_ptr, auto) {
+            using item_type = std::remove_cvref_t<decltype(t.*member_ptr)>;
+            if constexpr (is_cdata_member<item_type>()) {
+              add_cdata(t.*member_ptr, value, first_cdata);
+            }
+          });
+          first_cdata = false;
+        });
+  }
+  for (size_t i = 0; i < tags::size; ++i) {
+    if (tags::required[i] && !found[i]) {
+      const auto name = tags::M::arr()[i];
+      missing_node_handler<U>(std::string_view(name.data(), name.size()));
+    }
+  }
+}
+
+// it is behind the name of the element
+template <int Flags, typename U, typename It>
+void read_element(U &t, It &it, It end) {
+  const auto skip_attribute = [](std::string_view, It, It) {};
+  if constexpr (is_namespace_v<U>) {
+    typename U::value_type value{};
+    read_element<Flags>(value, it, end);
+    t = U{std::move(value)};
+  } else if constexpr (is_std_optinal_v<U>) {
+    using value_type = typename U::value_type;
+    value_type value{};
+    if constexpr (is_reflection_v<value_type> || is_namespace_v<value_type> ||
+                  is_std_pair_v<value_type> || is_std_optinal_v<value_type>) {
+      read_element<Flags>(value, it, end);
+      t = std::move(value);
+    } else {
+      const bool empty = read_xml_attributes(it, end, skip_attribute);
+      if (auto text = read_xml_text<Flags>(it, end, empty); !text.empty()) {
+        parse_xml_item<Flags, It>(value, text);
+        t = std::move(value);
       }
+    }
+  } else if constexpr (is_std_pair_v<U>) {
+    const bool empty = read_xml_attributes(
+        it, end, [&](std::string_view name, It first, It last) {
+          parse_xml_attribute<Flags, It>(t.second, name,
+                                         xml_value<Flags>(first, last));
+        });
+    if constexpr (is_reflection_v<decltype(t.first)>) {
+      read_object<Flags>(t.first, it, end, empty);
     } else {
-      static_assert(!sizeof(member_ptr_type), "type not supported");
+      parse_xml_item<Flags, It>(t.first, read_xml_text<Flags>(it, end, empty));
     }
-  });
+  } else if constexpr (is_reflection_v<U>) {
+    const bool empty = read_xml_attributes(
+        it, end, [&](std::string_view name, It first, It last) {
+          if constexpr (xml_tags<U>::has_attributes) {
+            const auto value = xml_value<Flags>(first, last);
+            for_each(t, [&](const auto member_ptr, auto) {
+              using item_type = std::remove_cvref_t<decltype(t.*member_ptr)>;
+              if constexpr (is_map_container<item_type>::value) {
+                parse_xml_attribute<Flags, It>(t.*member_ptr, name, value);
+              }
+            });
+          }
+        });
+    read_object<Flags>(t, it, end, empty);
+  } else {
+    const bool empty = read_xml_attributes(it, end, skip_attribute);
+    parse_xml_item<Flags, It>(t, read_xml_text<Flags>(it, end, empty));
+  }
 }
 
-template <int Flags = 0, typename T,
-          typename = std::enable_if_t<is_reflection<T>::value>>
-inline bool from_xml(T &&t, char *buf) {
-  if (!g_xml_read_err.empty()) {
-    g_xml_read_err.clear();
+template <int Flags, typename U, typename It>
+IGUANA_INLINE void read_xml_document(U &t, It &it, It end) {
+  skip_xml_prolog(it, end);
+  if (it == end) {
+    return;
   }
+  if (*it != '<') [[unlikely]]
+    throw_xml_error("expected <");
+  ++it;
+  read_xml_name(it, end); // the root element may have any name
+  read_element<Flags>(t, it, end);
+}
+} // namespace detail
+
+// Reads t from the null terminated xml in buf in a single pass, from the tags
+// straight into the members without building a document tree. Entities are
+// decoded in place, so buf is modified and std::string_view members point
+// into it. Of the rapidxml parse flags parse_no_entity_translation (part of
+// parse_non_destructive and parse_fastest) and parse_trim_whitespace are
+// honoured. Nothing is printed, a failure is described by err. A string
+// literal is no char * here, it is read by the std::string_view overload.
+template <int Flags = 0, typename T, typename Buf,
+          typename = std::enable_if_t<is_reflection<T>::value &&
+                                      std::is_same_v<Buf, char *>>>
+inline bool from_xml(T &&t, Buf buf, xml_error &err) {
+  char *it = buf;
   try {
-    rapidxml::xml_document<> doc;
-    doc.parse<Flags>(buf);
+    detail::read_xml_document<Flags>(t, it, buf + std::strlen(buf));
+    err.message.clear();
+    err.offset = 0;
+    return true;
+  } catch (std::exception &e) {
+    err.message = e.what();
+    err.offset = static_cast<size_t>(it - buf);
+  }
+  return false;
+}
 
-    auto fisrt_node = doc.first_node();
-    if (fisrt_node)
-      do_read(fisrt_node, t);
+// the message of a failure is kept for get_last_read_err() on this thread
+template <int Flags = 0, typename T, typename Buf,
+          typename = std::enable_if_t<is_reflection<T>::value &&
+                                      std::is_same_v<Buf, char *>>>
+inline bool from_xml(T &&t, Buf buf) {
+  xml_error err;
+  const bool r = from_xml<Flags>(std::forward<T>(t), buf, err);
+  g_xml_read_err = std::move(err.message);
+  return r;
+}
 
+// Reads t from xml without ever writing to it, so read only memory such as
+// a shared buffer or a mapped file can be parsed without a copy. xml need
+// not be null terminated. std::string members get the text with its
+// entities decoded, std::string_view members point at the raw text.
+template <int Flags = 0, typename T,
+          typename = std::enable_if_t<is_reflection<T>::value>>
+inline bool from_xml(T &&t, std::string_view xml, xml_error &err) {
+  const char *it = xml.data();
+  try {
+    detail::read_xml_document<Flags>(t, it, xml.data() + xml.size());
+    err.message.clear();
+    err.offset = 0;
     return true;
   } catch (std::exception &e) {
-    g_xml_read_err = e.what();
-    std::cout << e.what() << "\n";
+    err.message = e.what();
+    err.offset = static_cast<size_t>(it - xml.data());
   }
-
   return false;
 }
 
+template <int Flags = 0, typename T,
+          typename = std::enable_if_t<is_reflection<T>::value>>
+inline bool from_xml(T &&t, std::string_view xml) {
+  xml_error err;
+  const bool r = from_xml<Flags>(std::forward<T>(t), xml, err);
+  g_xml_read_err = std::move(err.message);
+  return r;
+}
+
+// Parses the file in place in a private mapping, see mmap_file. file owns
+// the mapping, std::string_view members of t point into it.
+template <int Flags = 0, typename T,
+          typename = std::enable_if_t<is_reflection<T>::value>>
+inline bool from_xml_file(T &&t, const std::string &filename, mmap_file &file,
+                          xml_error &err) {
+  if (auto ec = file.open(filename); ec) {
+    err = {ec.message(), 0};
+    return false;
+  }
+  return from_xml<Flags>(std::forward<T>(t), file.data(), err);
+}
+
+template <int Flags = 0, typename T,
+          typename = std::enable_if_t<is_reflection<T>::value>>
+inline bool from_xml_file(T &&t, const std::string &filename,
+                          mmap_file &file) {
+  xml_error err;
+  const bool r = from_xml_file<Flags>(std::forward<T>(t), filename, file, err);
+  g_xml_read_err = std::move(err.message);
+  return r;
+}
+
+// t must not hold std::string_view members, the file is unmapped on return
+template <int Flags = 0, typename T,
+          typename = std::enable_if_t<is_reflection<T>::value>>
+inline bool from_xml_file(T &&t, const std::string &filename) {
+  mmap_file file;
+  return from_xml_file<Flags>(std::forward<T>(t), filename, file);
+}
+
 inline std::string get_last_read_err() { return g_xml_read_err; }
 } // namespace iguana
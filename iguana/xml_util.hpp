@@ -0,0 +1,314 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#include "define.h"
+
+namespace iguana::detail {
+
+[[noreturn]] IGUANA_INLINE void throw_xml_error(const char *what) {
+  throw std::invalid_argument(what);
+}
+
+IGUANA_INLINE constexpr bool is_xml_space(char c) noexcept {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// the characters a tag or an attribute name ends at
+inline constexpr auto xml_name_end = [] {
+  std::array<bool, 256> table{};
+  for (char c : std::string_view(" \t\n\r/>?=\0", 10)) {
+    table[static_cast<uint8_t>(c)] = true;
+  }
+  return table;
+}();
+
+template <typename It> IGUANA_INLINE void skip_xml_ws(It &it, It end) {
+  while (it != end && is_xml_space(*it)) {
+    ++it;
+  }
+}
+
+// the first c in [it, end), end if there is none
+template <typename It> IGUANA_INLINE It find_xml_char(It it, It end, char c) {
+  auto p = static_cast<const char *>(
+      std::memchr(&*it, c, static_cast<size_t>(end - it)));
+  return p == nullptr ? end : it + (p - &*it);
+}
+
+template <typename It>
+IGUANA_INLINE std::string_view read_xml_name(It &it, It end) {
+  const It first = it;
+  while (it != end && !xml_name_end[static_cast<uint8_t>(*it)]) {
+    ++it;
+  }
+  if (it == first) [[unlikely]]
+    throw_xml_error("expected element name");
+  return {&*first, static_cast<size_t>(it - first)};
+}
+
+// moves it behind the next terminator
+template <typename It>
+IGUANA_INLINE void skip_xml_past(It &it, It end, std::string_view terminator,
+                                 const char *what) {
+  const std::string_view rest(&*it, static_cast<size_t>(end - it));
+  const size_t pos = rest.find(terminator);
+  if (pos == std::string_view::npos) [[unlikely]]
+    throw_xml_error(what);
+  it += pos + terminator.size();
+}
+
+template <typename It>
+IGUANA_INLINE bool starts_with(It it, It end, std::string_view prefix) {
+  return static_cast<size_t>(end - it) >= prefix.size() &&
+         std::memcmp(&*it, prefix.data(), prefix.size()) == 0;
+}
+
+// it is on the '<' of a comment, a processing instruction or a doctype
+template <typename It> IGUANA_INLINE void skip_xml_misc(It &it, It end) {
+  if (it[1] == '?') {
+    skip_xml_past(it, end, "?>", "expected ?>");
+  } else if (starts_with(it, end, "<!--")) {
+    skip_xml_past(it, end, "-->", "expected -->");
+  } else {
+    // <!DOCTYPE ...> and other declarations, the internal subset of a
+    // doctype may hold '>' between its brackets
+    size_t depth = 0;
+    for (it += 2; it != end; ++it) {
+      if (*it == '[') {
+        ++depth;
+      } else if (*it == ']') {
+        --depth;
+      } else if (*it == '>' && depth == 0) {
+        ++it;
+        return;
+      }
+    }
+    throw_xml_error("expected >");
+  }
+}
+
+// it is on the '<' of a CDATA section, returns its content
+template <typename It>
+IGUANA_INLINE std::string_view read_xml_cdata(It &it, It end) {
+  it += 9; // <![CDATA[
+  const It first = it;
+  skip_xml_past(it, end, "]]>", "expected ]]>");
+  return {&*first, static_cast<size_t>(it - first) - 3};
+}
+
+// it is on the '<' of an end tag, the name is not checked
+template <typename It> IGUANA_INLINE void skip_xml_end_tag(It &it, It end) {
+  it += 2;
+  while (it != end && !xml_name_end[static_cast<uint8_t>(*it)]) {
+    ++it;
+  }
+  skip_xml_ws(it, end);
+  if (it == end || *it != '>') [[unlikely]]
+    throw_xml_error("expected >");
+  ++it;
+}
+
+// Reads the attributes of a start tag, it is behind the element name. f(name,
+// first, last) is called for every attribute with the raw value in [first,
+// last). it is behind the tag afterwards, returns true for an empty element
+// such as <a/>.
+template <typename It, typename F>
+IGUANA_INLINE bool read_xml_attributes(It &it, It end, F &&f) {
+  while (true) {
+    skip_xml_ws(it, end);
+    if (it == end) [[unlikely]]
+      throw_xml_error("unexpected end of data");
+    if (*it == '>') {
+      ++it;
+      return false;
+    }
+    if (*it == '/') {
+      ++it;
+      if (it == end || *it != '>') [[unlikely]]
+        throw_xml_error("expected >");
+      ++it;
+      return true;
+    }
+    const auto name = read_xml_name(it, end);
+    skip_xml_ws(it, end);
+    if (it == end || *it != '=') [[unlikely]]
+      throw_xml_error("expected =");
+    ++it;
+    skip_xml_ws(it, end);
+    if (it == end || (*it != '"' && *it != '\'')) [[unlikely]]
+      throw_xml_error("expected ' or \"");
+    const char quote = *it++;
+    const It last = find_xml_char(it, end, quote);
+    if (last == end) [[unlikely]]
+      throw_xml_error("expected ' or \"");
+    f(name, it, last);
+    it = last + 1;
+  }
+}
+
+// Reads the content of an element up to and including its end tag, it is
+// behind the start tag. text(first, last) receives every run of character
+// data, child(name) every child element with it behind the name and must
+// consume the child, cdata(value) every CDATA section. Comments and
+// processing instructions are skipped.
+template <typename It, typename Text, typename Child, typename Cdata>
+IGUANA_INLINE void read_xml_content(It &it, It end, Text &&text, Child &&child,
+                                    Cdata &&cdata) {
+  while (true) {
+    const It lt = find_xml_char(it, end, '<');
+    if (end - lt < 2) [[unlikely]] {
+      it = lt;
+      throw_xml_error("unexpected end of data");
+    }
+    if (lt != it) {
+      text(it, lt);
+    }
+    it = lt;
+    switch (it[1]) {
+    case '/':
+      skip_xml_end_tag(it, end);
+      return;
+    case '!':
+      if (starts_with(it, end, "<![CDATA[")) {
+        cdata(read_xml_cdata(it, end));
+      } else {
+        skip_xml_misc(it, end);
+      }
+      break;
+    case '?':
+      skip_xml_misc(it, end);
+      break;
+    default:
+      ++it;
+      child(read_xml_name(it, end));
+    }
+  }
+}
+
+// it is behind the name of an element that is not read, the element is
+// consumed up to and including its end tag
+template <typename It> void skip_xml_element(It &it, It end) {
+  if (read_xml_attributes(it, end, [](std::string_view, It, It) {})) {
+    return;
+  }
+  read_xml_content(
+      it, end, [](It, It) {},
+      [&](std::string_view) { skip_xml_element(it, end); },
+      [](std::string_view) {});
+}
+
+// moves it behind the xml declaration, comments and the doctype in front of
+// the root element
+template <typename It> IGUANA_INLINE void skip_xml_prolog(It &it, It end) {
+  while (true) {
+    skip_xml_ws(it, end);
+    if (end - it < 2 || *it != '<' || (it[1] != '?' && it[1] != '!')) {
+      return;
+    }
+    skip_xml_misc(it, end);
+  }
+}
+
+IGUANA_INLINE char *encode_utf8(uint32_t cp, char *out) {
+  if (cp < 0x80) {
+    *out++ = static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    *out++ = static_cast<char>(0xC0 | (cp >> 6));
+    *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    *out++ = static_cast<char>(0xE0 | (cp >> 12));
+    *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    *out++ = static_cast<char>(0xF0 | (cp >> 18));
+    *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+  }
+  return out;
+}
+
+// it is on the '&' of a character reference such as &#38; or &#x26;, returns
+// false if it is not a valid one
+template <typename It>
+IGUANA_INLINE bool decode_char_ref(It &it, It end, char *&out) {
+  It p = it + 2;
+  uint32_t base = 10;
+  if (p != end && *p == 'x') {
+    base = 16;
+    ++p;
+  }
+  const It digits = p;
+  uint32_t cp = 0;
+  for (; p != end && cp <= 0x10FFFF; ++p) {
+    uint32_t d;
+    if (*p >= '0' && *p <= '9') {
+      d = static_cast<uint32_t>(*p - '0');
+    } else if (base == 16 && (*p | 0x20) >= 'a' && (*p | 0x20) <= 'f') {
+      d = static_cast<uint32_t>((*p | 0x20) - 'a' + 10);
+    } else {
+      break;
+    }
+    cp = cp * base + d;
+  }
+  if (p == digits || p == end || *p != ';' || cp > 0x10FFFF) {
+    return false;
+  }
+  out = encode_utf8(cp, out);
+  it = p + 1;
+  return true;
+}
+
+// Decodes the predefined entities and the character references of [first,
+// last) into out, which may be first itself: the decoded text is never
+// longer than the raw one. Unknown entities are kept as they are. Returns the
+// end of the decoded text.
+template <typename It>
+IGUANA_INLINE char *decode_xml_entities(It first, It last, char *out) {
+  while (true) {
+    const It amp = find_xml_char(first, last, '&');
+    const auto n = static_cast<size_t>(amp - first);
+    if (out != &*first) {
+      std::memmove(out, &*first, n);
+    }
+    out += n;
+    first = amp;
+    if (first == last) {
+      return out;
+    }
+    const auto put = [&](char c, size_t len) {
+      *out++ = c;
+      first += len;
+    };
+    if (starts_with(first, last, "&lt;")) {
+      put('<', 4);
+    } else if (starts_with(first, last, "&gt;")) {
+      put('>', 4);
+    } else if (starts_with(first, last, "&amp;")) {
+      put('&', 5);
+    } else if (starts_with(first, last, "&quot;")) {
+      put('"', 6);
+    } else if (starts_with(first, last, "&apos;")) {
+      put('\'', 6);
+    } else if (last - first < 2 || first[1] != '#' ||
+               !decode_char_ref(first, last, out)) {
+      put('&', 1);
+    }
+  }
+}
+
+IGUANA_INLINE std::string_view trim_xml_space(std::string_view str) {
+  while (!str.empty() && is_xml_space(str.front())) {
+    str.remove_prefix(1);
+  }
+  while (!str.empty() && is_xml_space(str.back())) {
+    str.remove_suffix(1);
+  }
+  return str;
+}
+
+} // namespace iguana::detail
@@ -5,18 +5,21 @@
 #ifndef IGUANA_XML17_HPP
 #define IGUANA_XML17_HPP
 #include "reflection.hpp"
+#include "sink.hpp"
 #include "type_traits.hpp"
 #include <algorithm>
 #include <cctype>
 #include <functional>
 #include <msstl/charconv.hpp>
-#include <rapidxml_print.hpp>
+#include <optional>
 #include <string.h>
 
 namespace iguana {
-inline std::string g_xml_write_err;
-template <typename Stream, typename T>
-inline void to_xml_impl(Stream &s, T &&t, std::string_view name = "");
+// to_xml_pretty no longer fails, kept for get_last_write_err()
+inline thread_local std::string g_xml_write_err;
+template <bool Pretty = false, typename Stream, typename T>
+inline void to_xml_impl(Stream &s, T &&t, std::string_view name = "",
+                        size_t depth = 0);
 
 class any_t;
 class cdata_t;
@@ -33,9 +36,9 @@ inline std::enable_if_t<std::is_arithmetic_v<T>> render_xml_value(Stream &ss,
 
 template <typename Stream> inline void render_xml_value(Stream &ss, bool s) {
   if (s) {
-    ss.append("true");
+    ss.append("true", 4);
   } else {
-    ss.append("false");
+    ss.append("false", 5);
   }
 }
 
@@ -79,60 +82,204 @@ template <typename Stream> inline void render_head(Stream &ss, const char *s) {
   ss.push_back('>');
 }
 
-template <typename Stream, typename T>
-inline void render_xml_attr(Stream &ss, std::string_view name, T &&attr) {
+template <typename Stream>
+inline void render_indent(Stream &ss, size_t depth) {
+  for (size_t i = 0; i < depth; ++i) {
+    ss.push_back('\t');
+  }
+}
+
+// Writes str with the characters xml gives a meaning expanded into entity
+// references, all of them but noexpand.
+template <typename Stream>
+inline void render_xml_escaped(Stream &ss, std::string_view str,
+                               char noexpand = 0) {
+  size_t from = 0;
+  for (size_t i = 0; i < str.size(); ++i) {
+    std::string_view ref;
+    switch (str[i]) {
+    case '<':
+      ref = "&lt;";
+      break;
+    case '>':
+      ref = "&gt;";
+      break;
+    case '\'':
+      ref = "&apos;";
+      break;
+    case '"':
+      ref = "&quot;";
+      break;
+    case '&':
+      ref = "&amp;";
+      break;
+    default:
+      continue;
+    }
+    if (str[i] == noexpand) {
+      continue;
+    }
+    ss.append(str.data() + from, i - from);
+    ss.append(ref.data(), ref.size());
+    from = i + 1;
+  }
+  ss.append(str.data() + from, str.size() - from);
+}
+
+// the text of a value, nullopt for numbers and bools which need no escaping
+template <typename T>
+inline std::optional<std::string_view> xml_text_of(const T &value) {
+  using U = std::decay_t<T>;
+  if constexpr (is_str_v<U>) {
+    return std::string_view(value);
+  } else if constexpr (std::is_same_v<U, char>) {
+    return std::string_view(&value, 1);
+  } else if constexpr (std::is_same_v<U, any_t>) {
+    return value.get_value();
+  } else if constexpr (is_std_optinal_v<U>) {
+    return value.has_value() ? xml_text_of(*value)
+                             : std::optional<std::string_view>("");
+  } else {
+    return std::nullopt;
+  }
+}
+
+// A leaf value, pretty output escapes it the way rapidxml::print does.
+template <bool Pretty, typename Stream, typename T>
+inline void render_xml_text(Stream &ss, T &&value, char noexpand = 0) {
+  if constexpr (Pretty) {
+    if (auto text = xml_text_of(value)) {
+      render_xml_escaped(ss, *text, noexpand);
+      return;
+    }
+  }
+  render_xml_value(ss, std::forward<T>(value));
+}
+
+// the attributes of a start tag, each as name="value"
+template <bool Pretty, typename Stream, typename T>
+inline void render_xml_attributes(Stream &ss, T &&attr) {
   static_assert(is_map_container<std::decay_t<T>>::value,
                 "must be map container");
-  ss.append("<").append(name);
   for (auto &[k, v] : attr) {
-    ss.append(" ").append(k).append("=\"");
-    render_xml_value(ss, v);
-    ss.append("\"");
+    std::string_view key(k);
+    ss.push_back(' ');
+    ss.append(key.data(), key.size());
+    char quote = '"';
+    if constexpr (Pretty) {
+      // a value holding '"' is quoted with '\'' instead
+      if (auto text = xml_text_of(v);
+          text && text->find('"') != std::string_view::npos) {
+        quote = '\'';
+      }
+    }
+    ss.push_back('=');
+    ss.push_back(quote);
+    render_xml_text<Pretty>(ss, v, quote == '"' ? '\'' : '"');
+    ss.push_back(quote);
   }
-  ss.append(">");
 }
 
-template <typename Stream, typename T>
-inline void render_xml_node(Stream &ss, std::string_view name, T &&item) {
+// A leaf element, pretty output puts it on a line of its own at depth and
+// closes it as <name/> when it has no text. attr points to the attribute
+// map, if any.
+template <bool Pretty, typename Stream, typename T,
+          typename Attr = std::nullptr_t>
+inline void render_xml_leaf(Stream &ss, std::string_view name, T &&value,
+                            size_t depth, Attr attr = nullptr) {
+  if constexpr (Pretty) {
+    render_indent(ss, depth);
+  }
+  ss.push_back('<');
+  ss.append(name.data(), name.size());
+  if constexpr (!std::is_null_pointer_v<Attr>) {
+    if (attr != nullptr) {
+      render_xml_attributes<Pretty>(ss, *attr);
+    }
+  }
+  if constexpr (Pretty) {
+    if (auto text = xml_text_of(value); text && text->empty()) {
+      ss.append("/>\n", 3);
+      return;
+    }
+  }
+  ss.push_back('>');
+  render_xml_text<Pretty>(ss, std::forward<T>(value));
+  ss.append("</", 2);
+  ss.append(name.data(), name.size());
+  ss.push_back('>');
+  if constexpr (Pretty) {
+    ss.push_back('\n');
+  }
+}
+
+template <bool Pretty = false, typename Stream, typename T>
+inline void render_xml_node(Stream &ss, std::string_view name, T &&item,
+                            size_t depth = 0) {
   using U = std::decay_t<T>;
   if constexpr (is_std_pair_v<U>) {
-    render_xml_attr(ss, name, item.second);
-    render_xml_value(ss, item.first);
-    render_tail(ss, name.data());
+    render_xml_leaf<Pretty>(ss, name, item.first, depth, &item.second);
   } else if constexpr (std::is_same_v<cdata_t, U>) {
-    ss.append("<![CDATA[").append(item.get()).append("]]>");
+    if constexpr (Pretty) {
+      render_indent(ss, depth);
+    }
+    std::string_view cdata(item.get());
+    ss.append("<![CDATA[", 9);
+    ss.append(cdata.data(), cdata.size());
+    ss.append("]]>", 3);
+    if constexpr (Pretty) {
+      ss.push_back('\n');
+    }
   } else {
-    render_head(ss, name.data());
-    render_xml_value(ss, std::forward<T>(item));
-    render_tail(ss, name.data());
+    render_xml_leaf<Pretty>(ss, name, std::forward<T>(item), depth);
   }
 }
 
-template <typename Stream, typename T>
-inline void render_xml_value0(Stream &ss, const T &v, std::string_view name) {
+template <bool Pretty = false, typename Stream, typename T>
+inline void render_xml_value0(Stream &ss, const T &v, std::string_view name,
+                              size_t depth = 0) {
   for (auto &item : v) {
     using item_type = std::decay_t<decltype(item)>;
     if constexpr (is_reflection_v<item_type>) {
-      to_xml_impl(ss, item, name);
+      to_xml_impl<Pretty>(ss, item, name, depth);
     } else {
-      render_xml_node(ss, name, item);
+      render_xml_node<Pretty>(ss, name, item, depth);
     }
   }
 }
 
-template <typename Stream, typename T>
-inline void to_xml_impl(Stream &s, T &&t, std::string_view name) {
+// Pretty output puts every element on a line of its own, indented by one tab
+// per depth, and closes elements without content as <name/>. It is written
+// in the same single pass as the compact output.
+template <bool Pretty, typename Stream, typename T>
+inline void to_xml_impl(Stream &s, T &&t, std::string_view name, size_t depth) {
   if (name.empty()) {
     name = iguana::get_name<T>();
   }
+  if constexpr (Pretty) {
+    render_indent(s, depth);
+  }
+  s.push_back('<');
+  s.append(name.data(), name.size());
   constexpr auto Idx = get_type_index<is_map_container, std::decay_t<T>>();
   if constexpr (Idx != iguana::get_value<std::decay_t<T>>()) {
-    auto attr_value = get<Idx>(t);
-    render_xml_attr(s, name, attr_value);
-  } else {
-    s.append("<").append(name).append(">");
+    render_xml_attributes<Pretty>(s, get<Idx>(t));
   }
-  for_each(std::forward<T>(t), [&t, &s](const auto v, auto i) {
+  // the start tag is ended before the first child, so that pretty output
+  // can close an element without children as <name/>
+  bool open = !Pretty;
+  if constexpr (!Pretty) {
+    s.push_back('>');
+  }
+  auto child = [&open, &s] {
+    if constexpr (Pretty) {
+      if (!open) {
+        s.append(">\n", 2);
+        open = true;
+      }
+    }
+  };
+  for_each(std::forward<T>(t), [&t, &s, &child, depth](const auto v, auto i) {
     using M = decltype(iguana_reflect_members(std::forward<T>(t)));
     constexpr auto Idx = decltype(i)::value;
     constexpr auto Count = M::value();
@@ -148,10 +295,11 @@ inline void to_xml_impl(Stream &s, T &&t, std::string_view name) {
         constexpr auto index_ul = find_underline(name.data());
         std::string ns(name.data(), name.size());
         ns[index_ul] = ':';
+        child();
         if constexpr (is_reflection<typename type_u::value_type>::value) {
-          to_xml_impl(s, (t.*v).get(), ns);
+          to_xml_impl<Pretty>(s, (t.*v).get(), ns, depth + 1);
         } else {
-          render_xml_node(s, ns, (t.*v).get());
+          render_xml_node<Pretty>(s, ns, (t.*v).get(), depth + 1);
         }
       } else if constexpr (is_std_optinal_v<type_u>) {
         if ((t.*v).has_value()) {
@@ -159,49 +307,62 @@ inline void to_xml_impl(Stream &s, T &&t, std::string_view name) {
           if constexpr (!is_str_v<value_type> &&
                         is_container<value_type>::value) {
             std::string_view sv = get_name<T, Idx>().data();
-            render_xml_value0(s, *(t.*v), sv);
+            if (!(*(t.*v)).empty()) {
+              child();
+            }
+            render_xml_value0<Pretty>(s, *(t.*v), sv, depth + 1);
           } else {
-            render_xml_node(s, get_name<T, Idx>().data(), *(t.*v));
+            child();
+            render_xml_node<Pretty>(s, get_name<T, Idx>().data(), *(t.*v),
+                                    depth + 1);
           }
         }
       } else if constexpr (!is_str_v<type_u> && is_container<type_u>::value) {
         std::string_view sv = get_name<T, Idx>().data();
-        render_xml_value0(s, t.*v, sv);
+        if (!(t.*v).empty()) {
+          child();
+        }
+        render_xml_value0<Pretty>(s, t.*v, sv, depth + 1);
       } else {
-        render_xml_node(s, get_name<T, Idx>().data(), t.*v);
+        child();
+        render_xml_node<Pretty>(s, get_name<T, Idx>().data(), t.*v, depth + 1);
       }
     } else {
-      to_xml_impl(s, t.*v, get_name<T, Idx>().data());
+      child();
+      to_xml_impl<Pretty>(s, t.*v, get_name<T, Idx>().data(), depth + 1);
     }
   });
-  s.append("</").append(name).append(">");
+  if constexpr (Pretty) {
+    if (!open) {
+      s.append("/>\n", 3);
+      return;
+    }
+    render_indent(s, depth);
+  }
+  s.append("</", 2);
+  s.append(name.data(), name.size());
+  s.push_back('>');
+  if constexpr (Pretty) {
+    s.push_back('\n');
+  }
 }
 
-template <typename Stream, typename T,
+template <sink_t Stream, typename T,
           typename = std::enable_if_t<is_reflection<T>::value>>
 inline void to_xml(T &&t, Stream &s) {
   to_xml_impl(s, std::forward<T>(t));
 }
 
+// Appends t to s indented, one element per line and a blank line at the end,
+// the layout rapidxml::print gives. Text and attribute values are escaped.
+// Flags is no longer used and kept for the callers that pass it, the output
+// is not reparsed so it always succeeds.
 template <int Flags = 0, typename Stream, typename T,
           typename = std::enable_if_t<is_reflection<T>::value>>
 inline bool to_xml_pretty(T &&t, Stream &s) {
-  to_xml_impl(s, std::forward<T>(t));
-
-  bool r = true;
-  try {
-    rapidxml::xml_document<> doc;
-    doc.parse<Flags>(s.data());
-    std::string ss;
-    rapidxml::print(std::back_inserter(ss), doc);
-    s = std::move(ss);
-  } catch (std::exception &e) {
-    r = false;
-    g_xml_write_err = e.what();
-    std::cerr << e.what() << "\n";
-  }
-
-  return r;
+  to_xml_impl<true>(s, std::forward<T>(t));
+  s.push_back('\n');
+  return true;
 }
 
 inline std::string get_last_write_err() { return g_xml_write_err; }
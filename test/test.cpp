@@ -1,15 +1,25 @@
 #include <cstddef>
+#include <cstdio>
 #include <string>
 #include <vector>
 #define DOCTEST_CONFIG_IMPLEMENT
 #include "doctest.h"
+#include "iguana/json_arena.hpp"
+#include "iguana/json_document.hpp"
+#include "iguana/json_index.hpp"
+#include "iguana/json_lines.hpp"
+#include "iguana/json_parallel.hpp"
+#include "iguana/json_pointer.hpp"
 #include "iguana/json_reader.hpp"
+#include "iguana/json_stream.hpp"
 #include "iguana/prettify.hpp"
+#include "iguana/sink.hpp"
 #include "iguana/value.hpp"
 #include <iguana/json_util.hpp>
 #include <iguana/json_writer.hpp>
 #include <iostream>
 #include <optional>
+#include <sstream>
 
 struct point_t {
   int x;
@@ -172,6 +182,707 @@ TEST_CASE("test from issues") {
   std::cout << std::boolalpha << test1.error << std::endl;
 }
 
+TEST_CASE("test arena dom parse") {
+  std::string str =
+      R"({"a": [1, 2.5, -3, true, null], "b": {"c": "d\u00e9\n"}, "e": "f", "g": []})";
+  iguana::json_arena arena;
+  iguana::parse(arena, str);
+  const auto &root = arena.root();
+  CHECK(sizeof(iguana::json_node) == 16);
+  CHECK(root.is_object());
+  CHECK(root.size() == 4);
+
+  const auto &a = root.at("a");
+  CHECK(a.size() == 5);
+  CHECK(a[0].get<int>() == 1);
+  CHECK(a[1].get<double>() == 2.5);
+  CHECK(a[2].get<int64_t>() == -3);
+  CHECK(a[3].get<bool>());
+  CHECK(a[4].is_null());
+  CHECK(a[0].get<double>() == 1);
+  CHECK_THROWS_AS(a[5], std::out_of_range);
+
+  CHECK(root.at("b").at("c").get<std::string_view>() == "d\u00e9\n");
+  CHECK(root.at("g").is_array());
+  CHECK(root.at("g").elements().empty());
+  CHECK(root.find("x") == nullptr);
+
+  std::vector<std::string_view> keys;
+  for (auto &member : root.members()) {
+    keys.push_back(member.key.get<std::string_view>());
+  }
+  CHECK(keys == std::vector<std::string_view>{"a", "b", "e", "g"});
+
+  std::error_code ec;
+  root.at("e").get<int>(ec);
+  CHECK(ec.message() == "wrong type, real type is string type");
+
+  // the view mode keeps unescaped strings in the input
+  iguana::parse<true>(arena, str);
+  auto e = arena.root().at("e").get<std::string_view>();
+  CHECK(e == "f");
+  CHECK(e.data() >= str.data());
+  CHECK(e.data() < str.data() + str.size());
+
+  iguana::json_error err;
+  iguana::parse(arena, std::string_view(R"({"a":[1,2})"), err);
+  CHECK(err.code == iguana::json_errc::expected_comma);
+  CHECK(err.offset == 9);
+  CHECK_THROWS_WITH(iguana::parse(arena, std::string_view("[1,")),
+                    "Unexpected end");
+}
+
+TEST_CASE("test dom parse 64 bit integers") {
+  std::string str =
+      R"([1, 3000000000, 9223372036854775807, -9223372036854775808,
+          18446744073709551615, 18446744073709551616, 1.0, 1.5e3, -0.5])";
+  iguana::jvalue val;
+  iguana::parse(val, str);
+  auto arr = val.to_array();
+  CHECK(arr[0].is_int());
+  CHECK(arr[1].is_int64());
+  CHECK(std::get<int64_t>(arr[1]) == 3000000000);
+  CHECK(std::get<int64_t>(arr[2]) == std::numeric_limits<int64_t>::max());
+  CHECK(std::get<int64_t>(arr[3]) == std::numeric_limits<int64_t>::min());
+  CHECK(arr[4].is_uint64());
+  CHECK(arr[4].to_uint64() == std::numeric_limits<uint64_t>::max());
+  CHECK(arr[5].is_double());
+  CHECK(arr[6].is_int());
+  CHECK(arr[7].is_int());
+  CHECK(arr[8].to_double() == -0.5);
+  CHECK(arr[0].to_int64() == 1);
+  CHECK(arr[1].to_uint64() == 3000000000);
+  CHECK_THROWS(arr[3].to_uint64());
+  std::error_code ec;
+  arr[8].to_int64(ec);
+  CHECK(ec.message() == "wrong type, real type is double type");
+
+  // raw numbers keep the source text
+  iguana::parse<false, true>(val, str);
+  auto raw = val.to_array();
+  CHECK(raw[0].is_raw_number());
+  CHECK(std::get<iguana::json_number>(raw[6]).str == "1.0");
+  CHECK(raw[5].to_uint64(ec) == 0);
+  CHECK(ec);
+  CHECK(raw[2].to_int64() == std::numeric_limits<int64_t>::max());
+  CHECK(std::get<iguana::json_number>(raw[7]).get<double>() == 1500);
+
+  // large integers used to parse as double, to_double still reads them
+  CHECK(arr[1].to_double() == 3000000000.0);
+  CHECK(arr[3].to_double() == -9223372036854775808.0);
+  CHECK(arr[4].to_double() == 18446744073709551615.0);
+  ec.clear();
+  CHECK(arr[5].to_double(ec) == 18446744073709551616.0);
+  CHECK(!ec);
+  CHECK(raw[1].to_double() == 3000000000.0);
+  CHECK(raw[7].to_double() == 1500);
+  CHECK(raw[8].to_double(ec) == -0.5);
+  CHECK(!ec);
+
+  iguana::json_arena arena;
+  iguana::parse(arena, str);
+  const auto &root = arena.root();
+  CHECK(root[2].get<int64_t>() == std::numeric_limits<int64_t>::max());
+  CHECK(root[4].is_uint());
+  CHECK(root[4].get<uint64_t>() == std::numeric_limits<uint64_t>::max());
+  CHECK(root[6].is_double());
+  CHECK_THROWS(root[4].get<int64_t>());
+
+  iguana::parse<true, true>(arena, str);
+  CHECK(arena.root()[1].is_raw_number());
+  CHECK(arena.root()[1].get<int64_t>() == 3000000000);
+}
+
+TEST_CASE("test lazy json_document") {
+  std::string str = R"({
+    "name": "tom", "skip": {"a": [1, {"b": "}"}], "c": "]"},
+    "ok": true, "list": [1, [2, 3], "x", null, 4.5],
+    "person": {"name": "jack", "ok": false}, "n\u0061me2": 5,
+    "q\"\u00e9\t": 6
+  })";
+  iguana::json_document doc(str);
+  CHECK(doc.root().is_object());
+  CHECK(doc["name"].get<std::string>() == "tom");
+  CHECK(doc["name"].get<std::string_view>() == "tom");
+  CHECK(doc["ok"].get<bool>());
+  CHECK(doc["skip"].raw() == R"({"a": [1, {"b": "}"}], "c": "]"})");
+  CHECK(doc["list"][1][1].get<int>() == 3);
+  CHECK(doc["list"][3].is_null());
+  CHECK(doc["list"][4].get<double>() == 4.5);
+  CHECK_THROWS_AS(doc["list"][5], std::out_of_range);
+  CHECK(doc["name2"].get<int>() == 5);
+  CHECK(!doc.find("nam"));
+  CHECK(!doc.find("name22"));
+  CHECK(doc["q\"\u00e9\t"].get<int>() == 6);
+  CHECK(!doc.find("q\"\u00e9"));
+  CHECK(!doc.find("q\"e\t"));
+  CHECK(!doc.find("missing"));
+  CHECK_THROWS_AS(doc["missing"], std::invalid_argument);
+
+  // materialize a subtree into a reflected struct
+  auto p = doc["person"].get<person>();
+  CHECK(p.name == "jack");
+  CHECK(!p.ok);
+
+  std::vector<std::string_view> keys;
+  for (auto &field : doc.root().members()) {
+    keys.push_back(field.key);
+  }
+  CHECK(keys == std::vector<std::string_view>{"name", "skip", "ok", "list",
+                                              "person", "n\\u0061me2",
+                                              "q\\\"\\u00e9\\t"});
+  size_t count = 0;
+  for (auto element : doc["list"].elements()) {
+    CHECK(element.valid());
+    ++count;
+  }
+  CHECK(count == 5);
+  CHECK(doc["name"].elements().begin() == doc["name"].elements().end());
+
+  std::error_code ec;
+  doc["name"].get<int>(ec);
+  CHECK(ec == iguana::json_errc::invalid_number);
+
+  iguana::json_document bad(std::string_view(R"({"a": 1 "b": 2})"));
+  CHECK(bad["a"].get<int>() == 1);
+  CHECK_THROWS_WITH(bad.find("b"), "Expected }");
+}
+
+TEST_CASE("test json pointer") {
+  std::string str = R"({
+    "statuses": [{"id": 1, "user": {"id": 10}}, {"id": 2, "user": {"id": 20}}],
+    "a/b": "slash", "m~n": "tilde", "": 0, "p": {"name": "tom", "ok": true}
+  })";
+  CHECK(iguana::get_at<int>(str, "/statuses/1/user/id") == 20);
+  CHECK(iguana::get_at<int>(str, "/statuses/0/id") == 1);
+  CHECK(iguana::get_at<std::string>(str, "/a~1b") == "slash");
+  CHECK(iguana::get_at<std::string_view>(str, "/m~0n") == "tilde");
+  CHECK(iguana::get_at<int>(str, "/") == 0);
+  CHECK(iguana::get_at<person>(str, "/p").name == "tom");
+
+  std::error_code ec;
+  iguana::get_at<int>(str, "/statuses/2/id", ec);
+  CHECK(ec == iguana::json_errc::pointer_not_found);
+  iguana::get_at<int>(str, "/statuses/01", ec);
+  CHECK(ec == iguana::json_errc::pointer_not_found);
+  iguana::get_at<int>(str, "statuses", ec);
+  CHECK(ec == iguana::json_errc::invalid_pointer);
+  iguana::get_at<int>(str, "/m~2n", ec);
+  CHECK(ec == iguana::json_errc::invalid_pointer);
+  CHECK_THROWS_WITH(iguana::get_at<int>(str, "/x"), "json pointer not found");
+
+  iguana::json_document doc(str);
+  auto user = iguana::at_pointer(doc, "/statuses/1/user");
+  CHECK(user.is_object());
+  CHECK(user["id"].get<int>() == 20);
+  CHECK(!iguana::at_pointer(doc, "/statuses/5"));
+  CHECK(iguana::at_pointer(doc, "").is_object());
+}
+
+TEST_CASE("test escape string in to_json") {
+  person p{"a\"b\\c\n\x01\x1f\t/\xc3\xa9", true};
+  std::string ss;
+  iguana::to_json(p, ss);
+  CHECK(ss ==
+        R"({"name":"a\"b\\c\n\u0001\u001f\t/)"
+        "\xc3\xa9"
+        R"(","ok":true})");
+  person p1;
+  iguana::from_json(p1, ss);
+  CHECK(p1 == p);
+
+  // escapes on both sides of the vector block boundaries
+  std::string long_str;
+  for (int i = 0; i < 200; ++i) {
+    long_str.push_back(i % 7 == 0 ? '"' : (i % 11 == 0 ? '\n' : 'a' + i % 26));
+  }
+  p.name = long_str;
+  ss.clear();
+  iguana::to_json(p, ss);
+  iguana::from_json(p1, ss);
+  CHECK(p1.name == long_str);
+
+  std::map<std::string, std::string> m{{"k\"ey", "v\\al"}};
+  ss.clear();
+  iguana::to_json(m, ss);
+  CHECK(ss == R"({"k\"ey":"v\\al"})");
+}
+
+TEST_CASE("test json key tokens") {
+  using first = iguana::detail::json_key_token<person, 0>;
+  using second = iguana::detail::json_key_token<person, 1>;
+  static_assert(first::size == 7 && second::size == 6);
+  CHECK(std::string_view(first::value.data(), first::size) == R"("name":)");
+  CHECK(std::string_view(second::value.data(), second::size) == R"(,"ok":)");
+
+  std::string ss;
+  iguana::to_json(person{"tom", false}, ss);
+  CHECK(ss == R"({"name":"tom","ok":false})");
+}
+
+TEST_CASE("test to_json_reserved") {
+  std::vector<person> v{{"tom", true}, {"jerry", false}};
+  std::string expected;
+  iguana::to_json(v, expected);
+  CHECK(iguana::json_size_hint(v) >= expected.size());
+
+  std::string ss = "prefix";
+  iguana::to_json_reserved(v, ss);
+  CHECK(ss == "prefix" + expected);
+
+  // every escape grows the output beyond the hint
+  std::map<std::string, std::optional<int>> m{
+      {std::string(100, '"'), 42}, {"\n\t", std::nullopt}};
+  expected.clear();
+  iguana::to_json(m, expected);
+  CHECK(iguana::json_size_hint(m) < expected.size());
+  ss.clear();
+  iguana::to_json_reserved(m, ss);
+  CHECK(ss == expected);
+}
+
+TEST_CASE("test output sinks") {
+  std::vector<person> v{{"tom", true}, {"jerry", false}, {"a\"b", true}};
+  std::string expected;
+  iguana::to_json(v, expected);
+
+  char buf[256];
+  iguana::fixed_buffer_sink fixed(buf, sizeof(buf));
+  iguana::to_json(v, fixed);
+  CHECK(!fixed.overflow());
+  CHECK(fixed.view() == expected);
+
+  iguana::fixed_buffer_sink small(buf, 10);
+  iguana::to_json(v, small);
+  CHECK(small.overflow());
+  CHECK(small.view() == expected.substr(0, 10));
+
+  // chunks smaller than most of the appends
+  iguana::buffer_chain_sink chain(4);
+  iguana::to_json(v, chain);
+  CHECK(chain.size() == expected.size());
+  CHECK(chain.str() == expected);
+  CHECK(chain.chunks().size() == (expected.size() + 3) / 4);
+
+  auto file = std::tmpfile();
+  REQUIRE(file);
+  {
+    iguana::fd_sink out(fileno(file), 8);
+    iguana::to_json(v, out);
+    CHECK(out.flush());
+    CHECK(out.written() == expected.size());
+  }
+  std::rewind(file);
+  std::string content(expected.size(), '\0');
+  CHECK(std::fread(content.data(), 1, content.size(), file) == content.size());
+  CHECK(content == expected);
+  std::fclose(file);
+
+  iguana::fd_sink bad(-1);
+  bad.append("x", 1);
+  CHECK(!bad.flush());
+  CHECK(bad.error() == std::errc::bad_file_descriptor);
+}
+
+struct stream_item_t {
+  int id;
+  std::string name;
+};
+REFLECTION(stream_item_t, id, name);
+
+struct stream_response_t {
+  std::string status;
+  std::vector<stream_item_t> items;
+  int count;
+};
+REFLECTION(stream_response_t, status, items, count);
+
+TEST_CASE("test json_stream_parser") {
+  stream_response_t expected{"o,k]\"}", {}, 0};
+  for (int i = 0; i < 50; ++i) {
+    expected.items.push_back({i, "[x\\\"" + std::to_string(i) + "},"});
+  }
+  expected.count = 50;
+  std::string json;
+  iguana::to_json(expected, json);
+
+  for (size_t step : {1, 3, 64, 100, 4096}) {
+    stream_response_t r;
+    iguana::json_stream_parser parser(r);
+    iguana::json_error err;
+    size_t max_buffered = 0;
+    for (size_t i = 0; i < json.size() && !err; i += step) {
+      err = parser.feed(std::string_view(json).substr(i, step));
+      max_buffered = (std::max)(max_buffered, parser.buffered());
+    }
+    CHECK(!err);
+    CHECK(parser.done());
+    CHECK(!parser.finish());
+    // only an incomplete item and the last chunk are held
+    CHECK(max_buffered < 64 + step);
+    CHECK(r.status == expected.status);
+    CHECK(r.count == 50);
+    REQUIRE(r.items.size() == 50);
+    CHECK(r.items[49].name == expected.items[49].name);
+  }
+
+  std::vector<stream_item_t> items;
+  iguana::json_stream_parser array_parser(items);
+  CHECK(!array_parser.feed(R"( [{"id":1,"name":"a"}, {"id")"));
+  CHECK(items.size() == 1);
+  CHECK(!array_parser.feed(R"(:2,"name":"b"}])"));
+  CHECK(array_parser.done());
+  CHECK(items.size() == 2);
+
+  std::vector<int> empty{1};
+  iguana::json_stream_parser empty_parser(empty);
+  CHECK(!empty_parser.feed("[ ]"));
+  CHECK(empty_parser.done());
+  CHECK(empty.empty());
+
+  std::vector<int> numbers;
+  iguana::json_stream_parser bad(numbers);
+  auto err = bad.feed("[1,2,]");
+  CHECK(err.code == iguana::json_errc::unexpected_value);
+  CHECK(err.offset == 5);
+  CHECK(bad.feed("3]").offset == err.offset);
+
+  iguana::json_stream_parser missing_comma(numbers);
+  CHECK(missing_comma.feed("[1 2]").code == iguana::json_errc::expected_comma);
+
+  iguana::json_stream_parser truncated(numbers);
+  CHECK(!truncated.feed("[1,2"));
+  CHECK(truncated.finish().code == iguana::json_errc::unexpected_end);
+}
+
+TEST_CASE("test json lines") {
+  std::vector<stream_item_t> items;
+  for (int i = 0; i < 100; ++i) {
+    items.push_back({i, "item " + std::to_string(i)});
+  }
+  std::string lines;
+  iguana::to_json_lines(items, lines);
+  CHECK(lines.substr(0, 24) == "{\"id\":0,\"name\":\"item 0\"}");
+  CHECK(std::count(lines.begin(), lines.end(), '\n') == 100);
+
+  std::vector<stream_item_t> read;
+  auto n = iguana::for_each_json_line<stream_item_t>(
+      lines, [&](stream_item_t &item) { read.push_back(item); });
+  CHECK(n == 100);
+  CHECK(read.size() == 100);
+  CHECK(read[99].name == "item 99");
+
+  // blank lines, \r\n and no newline at the end
+  n = iguana::for_each_json_line<stream_item_t>(
+      std::string_view("\n{\"id\":1}\r\n  \n{\"name\":\"b\"}"),
+      [&](stream_item_t &item) {
+        // members missing from a line are not left over from the last one
+        CHECK((item.id == 1 ? item.name == "" : item.id == 0));
+      });
+  CHECK(n == 2);
+
+  n = iguana::for_each_json_line<stream_item_t>(
+      lines, [](stream_item_t &item) { return item.id < 9; });
+  CHECK(n == 10);
+
+  std::istringstream in(lines);
+  size_t sum = 0;
+  iguana::json_error err;
+  n = iguana::for_each_json_line<stream_item_t>(
+      in, [&](stream_item_t &item) { sum += item.id; }, err, 64);
+  CHECK(!err);
+  CHECK(n == 100);
+  CHECK(sum == 4950);
+
+  std::string bad = "{\"id\":1}\n{\"id\":x}\n{\"id\":3}\n";
+  n = iguana::for_each_json_line<stream_item_t>(
+      bad, [](stream_item_t &) {}, err);
+  CHECK(n == 1);
+  CHECK(err.code == iguana::json_errc::invalid_number);
+  CHECK(err.offset == 15);
+  CHECK_THROWS(iguana::for_each_json_line<stream_item_t>(
+      bad, [](stream_item_t &) {}));
+  std::error_code ec;
+  n = iguana::for_each_json_line<stream_item_t>(
+      bad, [](stream_item_t &) {}, ec);
+  CHECK(n == 1);
+  CHECK(ec == iguana::json_errc::invalid_number);
+  CHECK(iguana::error_offset(ec) == 15);
+
+  // anything but whitespace after the record of a line is an error
+  read.clear();
+  bad = "{\"id\":1} garbage {\"id\":2}\n{\"id\":3}\n";
+  n = iguana::for_each_json_line<stream_item_t>(
+      bad, [&](stream_item_t &item) { read.push_back(item); }, err);
+  CHECK(n == 0);
+  CHECK(read.empty());
+  CHECK(err.code == iguana::json_errc::unexpected_value);
+  CHECK(err.offset == 9);
+  bad = "{\"id\":1}\n{\"id\":2}{\"id\":3} \r\n";
+  std::istringstream two(bad);
+  n = iguana::for_each_json_line<stream_item_t>(
+      two, [](stream_item_t &) {}, ec, 4);
+  CHECK(n == 1);
+  CHECK(ec == iguana::json_errc::unexpected_value);
+  CHECK(iguana::error_offset(ec) == 17);
+}
+
+TEST_CASE("test parallel json") {
+  // about 1 MB per thread is needed before a second thread is used
+  std::vector<stream_item_t> items;
+  for (int i = 0; i < 80000; ++i) {
+    items.push_back({i, "item [" + std::to_string(i) + "], {\\\"x\\\"}"});
+  }
+  std::string array;
+  iguana::to_json(items, array);
+  std::string lines;
+  iguana::to_json_lines(items, lines);
+  CHECK(array.size() > 3 * iguana::detail::parallel_min_chunk);
+
+  for (size_t threads : {1, 2, 3}) {
+    std::vector<stream_item_t> read;
+    iguana::json_error err;
+    iguana::from_json_parallel(read, array, err, threads);
+    CHECK(!err);
+    REQUIRE(read.size() == items.size());
+    CHECK(read[0].name == items[0].name);
+    CHECK(read.back().id == 79999);
+    CHECK(read.back().name == items.back().name);
+    size_t mismatched = 0;
+    for (size_t i = 0; i < items.size(); ++i) {
+      mismatched += read[i].id != items[i].id;
+    }
+    CHECK(mismatched == 0);
+
+    std::vector<stream_item_t> from_lines;
+    iguana::from_json_lines_parallel(from_lines, lines, err, threads);
+    CHECK(!err);
+    REQUIRE(from_lines.size() == items.size());
+    CHECK(from_lines[31234].id == 31234);
+    CHECK(from_lines.back().name == items.back().name);
+  }
+
+  std::vector<stream_item_t> read;
+  iguana::from_json_parallel(read, std::string_view(" [ ] "), 4);
+  CHECK(read.empty());
+
+  // a broken element in the middle of the array
+  std::string bad = array;
+  bad[bad.size() / 2 + bad.substr(bad.size() / 2).find("\"id\":") + 5] = 'x';
+  iguana::json_error err;
+  iguana::from_json_parallel(read, bad, err, 3);
+  CHECK(err.code == iguana::json_errc::invalid_number);
+  CHECK(bad[err.offset] == 'x');
+  CHECK(read.empty());
+  std::error_code ec;
+  iguana::from_json_parallel(read, array.substr(0, array.size() - 1), ec, 3);
+  CHECK(ec);
+  CHECK_THROWS(iguana::from_json_parallel(read, bad, 3));
+
+  bad = lines;
+  bad[bad.size() / 2 + bad.substr(bad.size() / 2).find("\"id\":") + 5] = 'x';
+  iguana::from_json_lines_parallel(read, bad, err, 3);
+  CHECK(err.code == iguana::json_errc::invalid_number);
+  CHECK(bad[err.offset] == 'x');
+  CHECK(read.empty());
+
+  // an exception of any worker reaches the caller once all are joined
+  std::vector<int> ran(4);
+  CHECK_THROWS_AS(iguana::detail::run_parallel(4,
+                                               [&](size_t i) {
+                                                 ran[i] = 1;
+                                                 if (i == 2)
+                                                   throw std::bad_alloc();
+                                               }),
+                  std::bad_alloc);
+  CHECK(ran == std::vector<int>{1, 1, 1, 1});
+}
+
+TEST_CASE("test from_json_padded") {
+  iguana::padded_string json(std::string_view(
+      R"({"id": 42, "name": "a \"quoted\" name, long enough for a block"})"));
+  stream_item_t item;
+  iguana::from_json_padded(item, json);
+  CHECK(item.id == 42);
+  CHECK(item.name == "a \"quoted\" name, long enough for a block");
+
+  std::array<bool, 3> flags{};
+  iguana::from_json_padded(flags, iguana::padded_string(
+                                      std::string_view("[true,false,true]")));
+  CHECK(flags == std::array<bool, 3>{true, false, true});
+
+  // the quote that closes the string lies behind the end of the input
+  std::string buf = R"({"id":1,"name":"tom"})";
+  buf.append(iguana::json_padding, '\0');
+  iguana::json_error err;
+  iguana::from_json_padded(item, {buf.data(), 19}, err);
+  CHECK(err.code == iguana::json_errc::expected_quote);
+  CHECK(err.offset == 19);
+  std::error_code ec;
+  iguana::from_json_padded(item, {buf.data(), 21}, ec);
+  CHECK(!ec);
+  CHECK(item.name == "tom");
+
+  // a literal cut off by the end
+  iguana::from_json_padded(flags, iguana::padded_string(
+                                      std::string_view("[true,fals")),
+                           err);
+  CHECK(err.code == iguana::json_errc::unexpected_end);
+  CHECK_THROWS(iguana::from_json_padded(item, iguana::padded_string()));
+
+  // the non-zero padding behind a sub-slice holds the rest of the literal
+  std::string tail = "[true,t";
+  const auto cut = tail.size();
+  tail.append("rue]");
+  tail.append(iguana::json_padding, 'x');
+  iguana::from_json_padded(flags, {tail.data(), cut}, err);
+  CHECK(err.code == iguana::json_errc::unexpected_end);
+  CHECK(err.offset <= cut);
+  std::string escape = R"({"id":1,"name":"\u)";
+  const auto escape_cut = escape.size();
+  escape.append(R"(0041"})");
+  escape.append(iguana::json_padding, 'x');
+  iguana::from_json_padded(item, {escape.data(), escape_cut}, err);
+  CHECK(err.code == iguana::json_errc::invalid_escape);
+}
+
+struct key_dispatch_t {
+  int a;
+  int ab;
+  int item_first_count;
+  int item_other_count;
+  int ___public;
+};
+REFLECTION(key_dispatch_t, a, ab, item_first_count, item_other_count,
+           ___public);
+
+TEST_CASE("test member key dispatch") {
+  using index = iguana::detail::key_index<key_dispatch_t>;
+  // the two long names share their length and first and last four bytes
+  static_assert(index::hash.full);
+  static_assert(index::find("item_other_count") == 3);
+  static_assert(index::find("public") == 4);
+  static_assert(index::find("___public") == index::size);
+  static_assert(index::find("") == index::size);
+  CHECK(index::find(std::string("ab")) == 1);
+  CHECK(index::find(std::string("ba")) == index::size);
+  CHECK(iguana::detail::key_index<stream_item_t>::find("name") == 1);
+
+  key_dispatch_t v{};
+  iguana::from_json(v, std::string_view(R"({"item_other_count": 4, "ab": 2,
+      "public": 5, "a": 1, "item_first_count": 3})"));
+  CHECK(v.a == 1);
+  CHECK(v.ab == 2);
+  CHECK(v.item_first_count == 3);
+  CHECK(v.item_other_count == 4);
+  CHECK(v.___public == 5);
+
+  // in declaration order every key is the predicted one
+  v = {};
+  iguana::from_json(v, std::string_view(R"({"a":1,"ab":2,"item_first_count":3,
+      "item_other_count":4,"public":5})"));
+  CHECK(v.ab == 2);
+  CHECK(v.___public == 5);
+
+  // keys that start with the predicted name
+  v = {};
+  iguana::from_json(v, std::string_view(R"({"ab":2,"a":1})"));
+  CHECK(v.a == 1);
+  CHECK(v.ab == 2);
+
+  iguana::json_error err;
+  iguana::from_json(v, std::string_view(R"({"a": 1, "abc": 2})"), err);
+  CHECK(err.code == iguana::json_errc::unknown_key);
+  CHECK(err.offset == 9);
+  iguana::from_json(v, std::string_view(R"({"a": 1, "item_xxxxx_count": 2})"),
+                    err);
+  CHECK(err.code == iguana::json_errc::unknown_key);
+  CHECK(err.offset == 9);
+  iguana::from_json(v, std::string_view(R"({"a)"), err);
+  CHECK(err.code == iguana::json_errc::expected_quote);
+}
+
+TEST_CASE("test skip values block by block") {
+  // the byte by byte skip is the reference, the values are shifted across
+  // the 64 byte block boundaries
+  std::vector<std::string> values = {
+      R"({"a": [1, {"b": "}}]]"}], "c\\": "\\\"}\\\\", "d": {}})",
+      R"([[], [[["]"]]], "\\\\]", {"x": [1,2,3]}])",
+      R"({"a": /* } */ 1, "b": "// }" // }
+         , "c": {"d": [ /*]*/ ]}})",
+      R"({"open": {"never": "closed")",
+      R"({"escape at the end": "\)"};
+  size_t mismatched = 0;
+  for (auto &value : values) {
+    for (size_t shift = 0; shift < 140; ++shift) {
+      std::string json(shift, ' ');
+      json += value;
+      json += std::string(shift % 7, ' ') + ", \"next\": 1}";
+      const char *begin = json.data() + shift;
+      const char *end = json.data() + json.size();
+      const char *expected = begin + 1;
+      if (*begin == '{') {
+        iguana::skip_until_closed<'{', '}'>(expected, end, 1);
+      } else {
+        iguana::skip_until_closed<'[', ']'>(expected, end, 1);
+      }
+      const char *it = begin;
+      if (*begin == '{') {
+        iguana::skip_until_closed<'{', '}'>(it, end);
+      } else {
+        iguana::skip_until_closed<'[', ']'>(it, end);
+      }
+      mismatched += it != expected;
+    }
+  }
+  CHECK(mismatched == 0);
+
+  std::string str(200, 'x');
+  str[0] = '"';
+  str[100] = '\\';
+  str[101] = '"';
+  str[150] = '"';
+  const char *it = str.data();
+  iguana::skip_string(it, str.data() + str.size());
+  CHECK(it - str.data() == 151);
+  it = str.data();
+  iguana::skip_string(it, str.data() + 101);
+  CHECK(it - str.data() == 101);
+}
+
+TEST_CASE("test from_json with a field mask") {
+  constexpr auto mask =
+      iguana::fields<&stream_response_t::status, &stream_response_t::count>();
+  static_assert(mask.test(0) && !mask.test(1) && mask.test(2));
+
+  std::string json = R"({"status": "ok", "items": [{"id": 1, "name": "a"},
+      {"id": 2, "name": "b"}], "count": 2})";
+  stream_response_t r;
+  r.items.push_back({7, "kept"});
+  iguana::from_json(r, json, mask);
+  CHECK(r.status == "ok");
+  CHECK(r.count == 2);
+  // skipped, not cleared
+  CHECK(r.items.size() == 1);
+  CHECK(r.items[0].name == "kept");
+
+  // a member outside of the mask is skipped even when it is malformed
+  iguana::json_error err;
+  std::string_view skipped = R"({"items": [1, , x], "count": 3})";
+  iguana::from_json(r, skipped, iguana::fields<&stream_response_t::count>(),
+                    err);
+  CHECK(!err);
+  CHECK(r.count == 3);
+
+  iguana::from_json(r, std::string_view(R"({"count": x})"), mask, err);
+  CHECK(err.code == iguana::json_errc::invalid_number);
+  CHECK(err.offset == 10);
+  std::error_code ec;
+  iguana::from_json(r, std::string_view(R"({"unknown": 1})"), mask, ec);
+  CHECK(ec);
+  CHECK_THROWS(iguana::from_json(r, std::string_view("[]"), mask));
+}
+
 TEST_CASE("test dom parse") {
   {
     std::string_view str = R"(null)";
@@ -744,6 +1455,123 @@ TEST_CASE("check some types") {
                 value_type{std::in_place_index_t<1>{}, &point_t::y});
 }
 
+TEST_CASE("test two-stage reader") {
+  {
+    std::string str = R"({"fixed_name_object": {"name0": "J\"a\\mes",
+      "name1": "Abra\u8001ham"}, "string_array": ["Cat", "Dog"],
+      "number": 3.14, "boolean": true, "string": "{[,:]}"})";
+    json0_obj_t obj;
+    iguana::from_json_indexed(obj, str);
+    CHECK(obj.fixed_name_object.name0 == "J\"a\\mes");
+    CHECK(obj.fixed_name_object.name1 == "Abra老ham");
+    CHECK(obj.string_array == std::vector<std::string>{"Cat", "Dog"});
+    CHECK(obj.number == 3.14);
+    CHECK(obj.boolean);
+    CHECK(obj.string == "{[,:]}");
+
+    json0_obj_t expected;
+    iguana::from_json(expected, std::begin(json0), std::end(json0));
+    iguana::json_index index(json0);
+    iguana::from_json(obj, index);
+    CHECK(obj.another_object.nested_object.v3s ==
+          expected.another_object.nested_object.v3s);
+    CHECK(obj.string_array == expected.string_array);
+  }
+  {
+    std::string str = R"({"tp": [1, 2.5, "iguana"]})";
+    tuple_t t;
+    iguana::from_json_indexed(t, str);
+    CHECK(std::get<2>(t.tp) == "iguana");
+
+    map_t m;
+    iguana::from_json_indexed(
+        m, std::string_view(R"({"map1": {"1": "hello"}, "map2": {}})"));
+    CHECK(m.map1.at(1) == "hello");
+    CHECK(m.map2.empty());
+  }
+  {
+    // out of order and prefixed keys
+    person p;
+    iguana::from_json_indexed(
+        p, std::string_view(R"({"ok": true, "@name": "tom"})"));
+    CHECK(p.name == "tom");
+    CHECK(p.ok);
+  }
+  {
+    person p;
+    CHECK_THROWS(iguana::from_json_indexed(p, std::string_view(R"({"name":"tom)")));
+    CHECK_THROWS(
+        iguana::from_json_indexed(p, std::string_view(R"({"name" "tom"})")));
+    std::vector<int> v;
+    CHECK_THROWS_WITH(iguana::from_json_indexed(v, std::string_view("[1 2]")),
+                      "Failed to parse number");
+    std::error_code ec;
+    iguana::from_json_indexed(v, std::string_view("[1, 2"), ec);
+    CHECK(ec);
+  }
+}
+
+TEST_CASE("test json_error") {
+  person p;
+  iguana::json_error err;
+  iguana::from_json(p, std::string_view(R"({"name":"tom", "ok":true})"), err);
+  CHECK(!err);
+  CHECK(p.name == "tom");
+  CHECK(p.ok);
+
+  iguana::from_json(p, std::string_view(R"({"name":"tom" "ok":true})"), err);
+  CHECK(err.code == iguana::json_errc::expected_comma);
+  CHECK(err.offset == 14);
+  CHECK(err.message() == "Expected ,");
+
+  iguana::from_json(p, std::string_view(R"({"name":"tom", "ok":tru})"), err);
+  CHECK(err.code == iguana::json_errc::invalid_literal);
+
+  iguana::from_json(p, std::string_view(R"({"name":"tom)"), err);
+  CHECK(err.code == iguana::json_errc::expected_quote);
+
+  iguana::from_json(p, std::string_view(R"({"dummy":1})"), err);
+  CHECK(err.code == iguana::json_errc::unknown_key);
+  CHECK(err.offset == 1);
+
+  std::vector<int> v;
+  iguana::from_json(v, std::string_view("[1, 2, x]"), err);
+  CHECK(err.code == iguana::json_errc::invalid_number);
+  CHECK(err.offset == 7);
+
+  iguana::from_json_indexed(v, std::string_view(R"([1, 2, "3"])"), err);
+  CHECK(err.code == iguana::json_errc::invalid_number);
+  CHECK(err.offset == 7);
+
+  iguana::jvalue val;
+  iguana::parse(val, std::string_view(R"({"a":1,"a":2})"), err);
+  CHECK(err.code == iguana::json_errc::duplicated_key);
+  CHECK(std::holds_alternative<std::nullptr_t>(val));
+}
+
+TEST_CASE("test json error category") {
+  person p;
+  std::error_code ec;
+  iguana::from_json(p, std::string_view(R"({"name":"tom" "ok":true})"), ec);
+  CHECK(ec == iguana::json_errc::expected_comma);
+  CHECK(ec != iguana::json_errc::expected_colon);
+  CHECK(iguana::error_offset(ec) == 14);
+  CHECK(ec.message() == "Expected , at offset 14");
+  CHECK(ec.category() == iguana::json_category());
+
+  iguana::from_json(p, std::string_view(R"({"name":"tom", "ok":true})"), ec);
+  CHECK(!ec);
+
+  iguana::from_json_file(p, "not_exist.json", ec);
+  CHECK(ec);
+  CHECK(ec.category() != iguana::json_category());
+
+  auto big = iguana::make_error_code(iguana::json_errc::unexpected_end,
+                                     size_t(1) << 40);
+  CHECK(big == iguana::json_errc::unexpected_end);
+  CHECK(iguana::error_offset(big) == iguana::json_category_impl::max_offset);
+}
+
 // doctest comments
 // 'function' : must be 'attribute' - see issue #182
 DOCTEST_MSVC_SUPPRESS_WARNING_WITH_PUSH(4007)
@@ -6,6 +6,9 @@
 #include "iguana/value.hpp"
 #define DOCTEST_CONFIG_IMPLEMENT
 #include <filesystem>
+#include <iguana/json_document.hpp>
+#include <iguana/json_index.hpp>
+#include <iguana/json_pointer.hpp>
 #include <iguana/json_reader.hpp>
 #include <iguana/json_util.hpp>
 #include <iguana/json_writer.hpp>
@@ -315,6 +318,77 @@ TEST_CASE("test instruments.json") {
   }
 }
 
+TEST_CASE("test two-stage reader") {
+  {
+    auto &&content = iguana::json_file_content("../data/citm_catalog.json");
+    citm_object_t expected, actual;
+    iguana::from_json(expected, content);
+    iguana::from_json_indexed(actual, content);
+    CHECK(actual.areaNames == expected.areaNames);
+    CHECK(actual.topicSubTopics == expected.topicSubTopics);
+    CHECK(actual.events.size() == expected.events.size());
+    CHECK(actual.performances.size() == expected.performances.size());
+    CHECK(actual.venueNames.value().PLEYEL_PLEYEL == "Salle Pleyel");
+  }
+  {
+    auto &&content = iguana::json_file_content("../data/gsoc-2018.json");
+    gsoc_object_t expected, actual;
+    iguana::from_json(expected, content);
+    iguana::from_json_indexed(actual, content);
+    CHECK(actual.size() == expected.size());
+    CHECK(actual.rbegin()->second.author.name == "Oleg Serikov");
+    CHECK(actual.begin()->second.description ==
+          expected.begin()->second.description);
+  }
+  {
+    auto &&content = iguana::json_file_content("../data/github_events.json");
+    std::vector<githubEvents::event_t> expected, actual;
+    iguana::from_json(expected, content);
+    iguana::from_json_indexed(actual, content);
+    CHECK(actual.size() == expected.size());
+    CHECK(actual.back().id == expected.back().id);
+    CHECK(actual.back().payload.commits.has_value() ==
+          expected.back().payload.commits.has_value());
+  }
+  {
+    auto &&content = iguana::json_file_content("../data/random.json");
+    random_t expected, actual;
+    iguana::from_json(expected, content);
+    iguana::from_json_indexed(actual, content);
+    CHECK(actual.result.size() == expected.result.size());
+    CHECK(actual.result.back().email == expected.result.back().email);
+    CHECK(actual.result.back().admin == expected.result.back().admin);
+  }
+}
+
+TEST_CASE("test twitter.json ids") {
+  auto &&content = iguana::json_file_content("../data/twitter.json");
+  iguana::jvalue val;
+  iguana::parse(val, content);
+  auto &&statuses = val.at<iguana::jarray>("statuses");
+  auto &&status = statuses[0].to_object();
+  CHECK(status["id"].is_int64());
+  CHECK(status["id"].to_int64() == 505874924095815700);
+
+  auto &&user = status["user"].to_object();
+  CHECK(iguana::get_at<int64_t>(content, "/statuses/0/user/id") ==
+        user["id"].to_int64());
+  CHECK(iguana::get_at<std::string>(content, "/statuses/0/user/screen_name") ==
+        user["screen_name"].to_string());
+}
+
+TEST_CASE("test update-center.json lazy") {
+  auto &&content = iguana::json_file_content("../data/update-center.json");
+  iguana::json_document doc(content);
+  CHECK(doc["core"]["version"].get<std::string_view>() == "1.498");
+  CHECK(doc["plugins"]["zubhium"]["version"].get<std::string>() == "0.1.6");
+  size_t count = 0;
+  for ([[maybe_unused]] auto &field : doc["plugins"].members()) {
+    ++count;
+  }
+  CHECK(count == 654);
+}
+
 // doctest comments
 // 'function' : must be 'attribute' - see issue #182
 DOCTEST_MSVC_SUPPRESS_WARNING_WITH_PUSH(4007) int main(int argc, char **argv) {
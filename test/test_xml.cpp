@@ -6,9 +6,14 @@
 #include "doctest.h"
 #include "iguana/xml_reader.hpp"
 #include "iguana/xml_writer.hpp"
+#include "iguana/sink.hpp"
 #include "rapidxml_print.hpp"
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <optional>
+#include <sstream>
+#include <thread>
 
 struct simple_t {
   std::vector<int> a;
@@ -272,6 +277,50 @@ TEST_CASE("test attribute with map") {
   CHECK(b2.__attr["price"] == 79.9f);
 }
 
+TEST_CASE("test to_xml into a fixed buffer") {
+  book_attr_t b;
+  b.__attr["id"] = 5;
+  b.title = "C++ templates";
+  std::string expected;
+  iguana::to_xml(b, expected);
+
+  char buf[256];
+  iguana::fixed_buffer_sink sink(buf, sizeof(buf));
+  iguana::to_xml(b, sink);
+  CHECK(!sink.overflow());
+  CHECK(sink.view() == expected);
+}
+
+struct book_view_t {
+  std::string_view title;
+  int pages;
+};
+REFLECTION(book_view_t, title, pages);
+TEST_CASE("test from_xml_file") {
+  std::string filename = "test_mmap.xml";
+  {
+    std::ofstream out(filename, std::ios::binary);
+    out << "<book_view_t><title>C++ templates</title><pages>832</pages>"
+           "</book_view_t>";
+  }
+  iguana::mmap_file file;
+  book_view_t b;
+  CHECK(iguana::from_xml_file(b, filename, file));
+  CHECK(b.title == "C++ templates");
+  CHECK(b.pages == 832);
+  CHECK(b.title.data() > file.data());
+  CHECK(b.title.data() < file.data() + file.size());
+
+  // the in situ parse changed the private mapping only
+  book_view_t b2;
+  CHECK(iguana::from_xml_file(b2, filename, file));
+  CHECK(b2.title == "C++ templates");
+  std::filesystem::remove(filename);
+
+  CHECK(!iguana::from_xml_file(b, "not_exist.xml"));
+  CHECK(!iguana::get_last_read_err().empty());
+}
+
 struct book_attr_any_t {
   std::unordered_map<std::string, iguana::any_t> __attr;
   std::string title;
@@ -373,7 +422,9 @@ TEST_CASE("test exception") {
   CHECK_NOTHROW(iguana::from_xml(simple, str2.data())); // Failed to parse bool
   simple_t simple2{{1, 2, 3}, '|', 0, 1};
   std::string ss = "<<dd>>";
-  CHECK_FALSE(iguana::to_xml_pretty(simple2, ss)); // unexpected end of data
+  // written directly, what the sink holds already is not parsed
+  CHECK(iguana::to_xml_pretty(simple2, ss));
+  CHECK(ss.substr(0, 6) == "<<dd>>");
 
   std::string str3 = R"(
     <nested_t>
@@ -485,8 +536,8 @@ TEST_CASE("parse error") {
 
   simple_t simple2{{1, 2, 3}, '|', 0, 1};
   std::string ss = "<<dd>>";
-  CHECK_FALSE(iguana::to_xml_pretty(simple2, ss)); // unexpected end of data
-  CHECK(!iguana::get_last_write_err().empty());
+  CHECK(iguana::to_xml_pretty(simple2, ss));
+  CHECK(iguana::get_last_write_err().empty());
 }
 
 TEST_CASE("field not found") {
@@ -583,6 +634,210 @@ TEST_CASE("test cdata node") {
   CHECK(dscrp.cdata.get().empty());
 }
 
+struct entity_t {
+  std::string title;
+  std::string_view note;
+  std::vector<int> id;
+  std::unordered_map<std::string, std::string> __attr;
+};
+REFLECTION(entity_t, title, note, id, __attr);
+TEST_CASE("test single pass reader") {
+  std::string str = R"(<?xml version="1.0" encoding="UTF-8"?>
+    <!DOCTYPE entity_t [ <!ENTITY x "y"> ]>
+    <!-- leading comment -->
+    <entity_t href="a&amp;b" quote='say "hi"'>
+      <id>1</id>
+      <unknown attr="a > b"><deep><![CDATA[</entity_t>]]></deep><empty/></unknown>
+      <note>&lt;p&gt; &#65;&#x42; &unknown;</note>
+      <!-- <title>comment</title> -->
+      <id>2</id>
+      <?pi <title>instruction</title> ?>
+      <title>Tom &amp; Jerry &#x4E2D;</title>
+      <id>3</id>
+    </entity_t>
+  )";
+  entity_t e;
+  CHECK(iguana::from_xml(e, str.data()));
+  CHECK(e.title == "Tom & Jerry \xE4\xB8\xAD");
+  CHECK(e.note == "<p> AB &unknown;");
+  CHECK(e.id == std::vector{1, 2, 3});
+  CHECK(e.__attr["href"] == "a&b");
+  CHECK(e.__attr["quote"] == "say \"hi\"");
+
+  std::string raw =
+      "<entity_t><note>  a &amp; b  </note><title> t </title><id>1</id>"
+      "</entity_t>";
+  entity_t e2;
+  CHECK(iguana::from_xml<rapidxml::parse_no_entity_translation |
+                         rapidxml::parse_trim_whitespace>(e2, raw.data()));
+  CHECK(e2.note == "a &amp; b");
+  CHECK(e2.title == "t");
+
+  std::string truncated = "<entity_t><title>t</title><unknown><a></unknown>";
+  entity_t e3;
+  CHECK_FALSE(iguana::from_xml(e3, truncated.data()));
+}
+
+struct person_t {
+  std::string name;
+  std::optional<int> age;
+  std::vector<int> id;
+};
+REFLECTION(person_t, name, age, id);
+TEST_CASE("test blank text and repeated children") {
+  std::string str = "<person_t><name> </name><age>  </age></person_t>";
+  person_t p;
+  CHECK(iguana::from_xml(p, str.data()));
+  CHECK(p.name.empty());
+  CHECK(!p.age);
+
+  // the first of repeated children wins, containers take them all
+  std::string str2 = "<person_t><name>a</name><id>1</id><age>2</age>"
+                     "<name>b</name><age>3</age><id>4</id></person_t>";
+  person_t p2;
+  CHECK(iguana::from_xml(p2, str2.data()));
+  CHECK(p2.name == "a");
+  CHECK(p2.age == 2);
+  CHECK(p2.id == std::vector{1, 4});
+}
+
+struct wide_t {
+  int a;
+  int ab;
+  int item_first_count;
+  int item_other_count;
+  iguana::namespace_t<int> media_content;
+  std::string media_thumbnail;
+  std::vector<int> x;
+};
+REFLECTION(wide_t, a, ab, item_first_count, item_other_count, media_content,
+           media_thumbnail, x);
+TEST_CASE("test child lookup") {
+  using tags = iguana::detail::xml_tags<wide_t>;
+  static_assert(tags::find("a") == 0);
+  static_assert(tags::find("item_other_count") == 3);
+  static_assert(tags::find("media:content") == 4);
+  static_assert(tags::find("media_content") == tags::size);
+  static_assert(tags::find("abc") == tags::size);
+
+  std::string str = R"(
+    <wide_t>
+      <x>1</x>
+      <item_other_count>4</item_other_count>
+      <media:content>5</media:content>
+      <x>2</x><x>3</x>
+      <ab>2</ab>
+      <unknown><a>0</a></unknown>
+      <a>1</a>
+      <media_thumbnail>t</media_thumbnail>
+      <item_first_count>3</item_first_count>
+      <x>4</x>
+    </wide_t>
+  )";
+  wide_t w;
+  CHECK(iguana::from_xml(w, str.data()));
+  CHECK(w.a == 1);
+  CHECK(w.ab == 2);
+  CHECK(w.item_first_count == 3);
+  CHECK(w.item_other_count == 4);
+  CHECK(w.media_content.get() == 5);
+  CHECK(w.media_thumbnail == "t");
+  CHECK(w.x == std::vector{1, 2, 3, 4});
+}
+
+TEST_CASE("test xml_error") {
+  std::string sparse = "<book_t><title>C++ templates</title></book_t>";
+  std::string bad = "<book_t><title>C++ templates</title><edition>x</edition>";
+  std::unordered_map<std::string, iguana::any_t> attr;
+  attr.emplace("id", iguana::any_t("x5"));
+  book_t book, book2;
+  iguana::xml_error err, err2;
+
+  std::stringstream out;
+  auto old = std::cout.rdbuf(out.rdbuf());
+  bool r = iguana::from_xml(book, sparse.data(), err);
+  bool r2 = iguana::from_xml(book2, bad.data(), err2);
+  bool r3 = attr["id"].get<int>().first;
+  std::cout.rdbuf(old);
+
+  CHECK(out.str().empty()); // nothing is printed
+  CHECK(r);
+  CHECK(!err);
+  CHECK(book.title == "C++ templates");
+  CHECK_FALSE(r2);
+  CHECK(err2);
+  CHECK(err2.message == "Failed to parse number");
+  CHECK(err2.offset == bad.find("</edition>") + 10); // behind the element
+  CHECK_FALSE(r3);
+
+  // the message of the convenience overload is per thread
+  std::thread([] {
+    std::string str = "error xml";
+    simple_t p;
+    CHECK_FALSE(iguana::from_xml(p, str.data()));
+    CHECK(iguana::get_last_read_err() == "expected <");
+  }).join();
+  std::string ok = "<book_t><title>t</title></book_t>";
+  CHECK(iguana::from_xml(book, ok.data()));
+  CHECK(iguana::get_last_read_err().empty());
+}
+
+TEST_CASE("test from_xml with read only input") {
+  const std::string str = R"(
+    <entity_t href="a&amp;b">
+      <note>&lt;p&gt;</note>
+      <title>Tom &amp; Jerry &#65;</title>
+      <id>1</id>
+    </entity_t>)";
+  const std::string copy = str;
+  entity_t e;
+  iguana::xml_error err;
+  CHECK(iguana::from_xml(e, std::string_view(str), err));
+  CHECK(!err);
+  CHECK(str == copy); // never written to
+  CHECK(e.title == "Tom & Jerry A"); // owning strings are decoded
+  CHECK(e.note == "&lt;p&gt;");      // views keep the raw text
+  CHECK(e.__attr["href"] == "a&b");
+  CHECK(e.id == std::vector{1});
+
+  // no terminator is needed
+  std::string_view part = std::string_view(str).substr(0, str.find("<id>"));
+  entity_t e2;
+  CHECK_FALSE(iguana::from_xml(e2, part, err));
+  CHECK(err.message == "unexpected end of data");
+  CHECK(err.offset == part.size());
+
+  package_t package;
+  CHECK(iguana::from_xml(
+      package, R"(<package><version ver="1&lt;2">1.0</version></package>)"));
+  CHECK(package.version.first == "1.0");
+  CHECK(package.version.second["ver"] == "1<2");
+}
+
+TEST_CASE("test to_xml_pretty layout") {
+  entity_t e{"Tom & <Jerry>", "", {1, 2}, {{"quote", "say \"hi\""}}};
+  std::string ss;
+  CHECK(iguana::to_xml_pretty(e, ss));
+  CHECK(ss == "<entity_t quote='say \"hi\"'>\n"
+              "\t<title>Tom &amp; &lt;Jerry&gt;</title>\n"
+              "\t<note/>\n"
+              "\t<id>1</id>\n"
+              "\t<id>2</id>\n"
+              "</entity_t>\n\n");
+
+  entity_t e2;
+  CHECK(iguana::from_xml(e2, std::string_view(ss)));
+  CHECK(e2.title == e.title);
+  CHECK(e2.id == e.id);
+  CHECK(e2.__attr["quote"] == "say \"hi\"");
+
+  // the same layout into any sink
+  char buf[256];
+  iguana::fixed_buffer_sink sink(buf, sizeof(buf));
+  CHECK(iguana::to_xml_pretty(e, sink));
+  CHECK(sink.view() == ss);
+}
+
 CUSTOM_FIELDS(node_t, (title, user_title), (description, user_desc));
 
 TEST_CASE("get_custom_filed") {
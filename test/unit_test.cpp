@@ -259,7 +259,7 @@ TEST_CASE("test parse item char") {
     std::string str{R"("\)"};
     char test{};
     CHECK_THROWS_WITH(iguana::from_json(test, str.begin(), str.end()),
-                      "Unxpected end of buffer");
+                      "Unexpected end");
   }
   {
     std::string str{""};
@@ -603,6 +603,49 @@ struct book_t {
   std::vector<std::string_view> author;
 };
 REFLECTION(book_t, title, edition, author);
+TEST_CASE("test from_json_file with mmap") {
+  std::string filename = "test_mmap.json";
+  // a file that fills whole pages still has zero bytes behind it
+  std::string str = R"({"title":"C++ templates","author":["Josuttis"]})";
+  str.resize(4096, ' ');
+  {
+    std::ofstream out(filename, std::ios::binary);
+    out.write(str.data(), str.size());
+  }
+
+  iguana::mmap_file file;
+  book_t b;
+  iguana::from_json_file(b, filename, file);
+  CHECK(b.title == "C++ templates");
+  CHECK(b.author.at(0) == "Josuttis");
+  // the string_views point into the mapping
+  CHECK(b.title.data() > file.data());
+  CHECK(b.title.data() < file.data() + file.size());
+  CHECK(file.size() == 4096);
+  CHECK(file.data()[file.size()] == '\0');
+
+  std::error_code ec;
+  iguana::from_json_file(b, filename, file, ec);
+  CHECK(!ec);
+  std::filesystem::remove(filename);
+
+  iguana::from_json_file(b, "not_exist.json", file, ec);
+  CHECK(ec);
+  CHECK(!file.is_open());
+  CHECK_THROWS_AS(iguana::from_json_file(b, "not_exist.json", file),
+                  std::runtime_error);
+
+  std::ofstream("empty_mmap.json", std::ios::binary).close();
+  CHECK_THROWS_WITH(iguana::from_json_file(b, "empty_mmap.json", file),
+                    "empty file");
+  std::filesystem::remove("empty_mmap.json");
+
+  std::filesystem::create_directories("dummy_mmap_dir");
+  CHECK_THROWS_AS(iguana::from_json_file(b, "dummy_mmap_dir", file),
+                  std::runtime_error);
+  std::filesystem::remove("dummy_mmap_dir");
+}
+
 TEST_CASE("test the string_view") {
   {
     std::string str = R"("C++ \ntemplates")";